@@ -5,8 +5,13 @@
 #include <sys/socket.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
 
 
+static int openIdleFd(){
+    return ::open("/dev/null", O_RDONLY | O_CLOEXEC);
+}
+
 static int createNoneBlock(){
     int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if(sockfd < 0){
@@ -18,13 +23,19 @@ static int createNoneBlock(){
 /**
  * 维护了一个监听的channel和listenFd包裹的socket
  * 仅仅需要一个handleRead，注册在了channel内，当有新连接时，handleRead内部会调用TcpServer作为用户传入的newTcpConnection函数，建立新的conn。
+ * TcpServer每个loop一个Acceptor时：要么各自绑定一个SO_REUSEPORT的socket，由内核按四元组分发；
+ *          要么dup同一个监听socket，以EPOLLEXCLUSIVE注册，每个连接只唤醒一个loop
+ * handleRead一次最多accept acceptBatch_个连接，然后调用batchDoneCallback_，TcpServer借此把一批连接按subLoop分组，每个loop只投递一次
+ * idleFd_：进程fd用完时，先关掉它腾出一个fd，accept后立刻关闭这个连接，再重新占住，避免水平触发的监听fd一直可读而空转
  * 
 */
 Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusePort)
     :loop_(loop), 
     acceptSocket_(createNoneBlock()),
     acceptChannel_(loop, acceptSocket_.fd()),
-    listening_(false){
+    listening_(false),
+    acceptBatch_(kDefaultAcceptBatch),
+    idleFd_(openIdleFd()){
 
     acceptSocket_.setReuseAddr(true);
     acceptSocket_.setReusePort(reusePort);
@@ -33,9 +44,26 @@ Acceptor::Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusePor
     acceptChannel_.setReadCallback(std::bind(&Acceptor::handleRead, this));
 }
 
+Acceptor::Acceptor(EventLoop* loop, const Acceptor& shared)
+    :loop_(loop),
+    acceptSocket_(::fcntl(shared.acceptSocket_.fd(), F_DUPFD_CLOEXEC, 0)),
+    acceptChannel_(loop, acceptSocket_.fd()),
+    listening_(false),
+    acceptBatch_(shared.acceptBatch_),
+    idleFd_(openIdleFd()){
+    if(acceptSocket_.fd() < 0){
+        LOG_FATAL("%s:%s:%d dup listen socket err:%d", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    acceptChannel_.setExclusive(true);
+    acceptChannel_.setReadCallback(std::bind(&Acceptor::handleRead, this));
+}
+
 Acceptor::~Acceptor(){
     acceptChannel_.disableAll();
     acceptChannel_.remove();
+    if(idleFd_ >= 0){
+        ::close(idleFd_);
+    }
 }
 
 void Acceptor::listen(){
@@ -46,18 +74,37 @@ void Acceptor::listen(){
 
 
 void Acceptor::handleRead(){
-    InetAddress peerAddr;
-    int connfd = acceptSocket_.accept(&peerAddr);
-    if(connfd >= 0){
-        if(newConnectionCallback_){
-            newConnectionCallback_(connfd, peerAddr);
-        }else{
-            ::close(connfd);
+    for(int i = 0; i < acceptBatch_; ++i){
+        InetAddress peerAddr;
+        int connfd = acceptSocket_.accept(&peerAddr);
+        if(connfd >= 0){
+            if(newConnectionCallback_){
+                newConnectionCallback_(connfd, peerAddr);
+            }else{
+                ::close(connfd);
+            }
+            continue;
+        }
+        int savedErrno = errno;
+        if(savedErrno == ECONNABORTED || savedErrno == EINTR){
+            continue;
         }
-    }else{
-        LOG_ERROR("%s:%s:%d accept , err %d", __FILE__, __FUNCTION__, __LINE__, errno);
-        if(errno == EMFILE){
-            LOG_ERROR("%s:%s:%d sockfd reach limit, %d", __FILE__, __FUNCTION__, __LINE__, errno);
+        //多个loop监听同一个端口时，被唤醒的loop可能发现连接已经被别的loop取走了
+        if(savedErrno != EAGAIN){
+            LOG_ERROR("%s:%s:%d accept , err %d", __FILE__, __FUNCTION__, __LINE__, savedErrno);
         }
+        if((savedErrno == EMFILE || savedErrno == ENFILE) && idleFd_ >= 0){
+            LOG_ERROR("%s:%s:%d sockfd reach limit, %d", __FILE__, __FUNCTION__, __LINE__, savedErrno);
+            ::close(idleFd_);
+            idleFd_ = ::accept(acceptSocket_.fd(), nullptr, nullptr);
+            if(idleFd_ >= 0){
+                ::close(idleFd_);
+            }
+            idleFd_ = openIdleFd();
+        }
+        break;
+    }
+    if(batchDoneCallback_){
+        batchDoneCallback_();
     }
 }
\ No newline at end of file
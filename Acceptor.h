@@ -13,17 +13,35 @@ public:
     using NewConnectionCallback = std::function<void(int sockfd, const InetAddress&)>;
 
     Acceptor(EventLoop* loop, const InetAddress& listenAddr, bool reusePort);
+    //和另一个Acceptor共用同一个监听socket（dup出来的fd），以EPOLLEXCLUSIVE注册，多个loop各自accept同一个端口
+    Acceptor(EventLoop* loop, const Acceptor& shared);
     ~Acceptor();
 
     void setNewConnectionCallback(const NewConnectionCallback& cb){
         newConnectionCallback_ = cb;
     }
 
+    //一次可读事件里accept完一批连接之后调用，用于把这一批连接合并交给各个subLoop
+    void setBatchDoneCallback(const std::function<void()>& cb){
+        batchDoneCallback_ = cb;
+    }
+
+    static const int kDefaultAcceptBatch = 16;
+
+    //一次可读事件最多accept多少个连接
+    void setAcceptBatch(int batch){
+        acceptBatch_ = batch > 0 ? batch : 1;
+    }
+
     bool listening() const {
         return listening_;
     }
 
     void listen();
+
+    EventLoop* ownerLoop() const {
+        return loop_;
+    }
 private:
     void handleRead();
 
@@ -31,6 +49,10 @@ private:
     Socket acceptSocket_;
     Channel acceptChannel_;
     NewConnectionCallback newConnectionCallback_;
+    std::function<void()> batchDoneCallback_;
     bool listening_;
+    int acceptBatch_;
+    //预留的空闲fd，fd耗尽(EMFILE)时用它腾出一个位置把连接accept下来再关掉，避免监听fd一直可读导致空转
+    int idleFd_;
 
 };
\ No newline at end of file
@@ -0,0 +1,162 @@
+#include "AsyncLogging.h"
+#include "LogFile.h"
+
+#include <string.h>
+#include <inttypes.h>
+#include <chrono>
+#include <algorithm>
+
+/**
+ * AsyncLogging：
+ * 每个写日志的线程第一次append时，创建一个属于自己的LogRing（单生产者单消费者的字节环形缓冲），加锁登记到rings_，之后再也不加锁
+ * LogRing：head_/tail_是单调递增的字节计数，容量是2的幂。生产者只写tail_，消费者只写head_，靠acquire/release同步
+ *          一条日志要么整条写入，要么因为空间不够整条丢弃，所以消费者不需要解析记录边界，按字节原样写文件即可
+ * 
+ * 后台线程：每flushInterval_秒，或者某个ring超过半满时被唤醒，遍历所有ring把可读字节写入LogFile，然后flush
+ *          线程退出后ring仍被rings_持有，等后台线程把剩余数据写完再释放
+ * 唤醒：ring超过半满才通知后台线程，wakeupPending_保证一轮里只有第一个线程去拿锁notify
+*/
+
+namespace{
+    std::atomic<uint64_t> g_numAsyncLogging(0);
+}
+
+class AsyncLogging::LogRing : noncopyable{
+public:
+    LogRing() : buffer_(new char[kRingSize]), head_(0), tail_(0){}
+
+    //生产者线程调用，返回是否需要唤醒后台线程
+    bool push(const char* data, size_t len, bool* full){
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        if(kRingSize - (tail - head) < len){
+            *full = true;
+            return true;
+        }
+        size_t offset = tail & (kRingSize - 1);
+        size_t first = std::min(len, kRingSize - offset);
+        memcpy(buffer_.get() + offset, data, first);
+        memcpy(buffer_.get(), data + first, len - first);
+        tail_.store(tail + len, std::memory_order_release);
+        *full = false;
+        return tail + len - head > kRingSize / 2;
+    }
+
+    //后台线程调用，把所有可读字节写入output
+    void drain(LogFile* output){
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        uint64_t tail = tail_.load(std::memory_order_acquire);
+        if(head == tail){
+            return;
+        }
+        size_t len = tail - head;
+        size_t offset = head & (kRingSize - 1);
+        size_t first = std::min(len, kRingSize - offset);
+        output->append(buffer_.get() + offset, first);
+        if(len > first){
+            output->append(buffer_.get(), len - first);
+        }
+        head_.store(tail, std::memory_order_release);
+    }
+
+    bool empty() const{
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    //生产者和消费者各自频繁写的变量放在不同的cache line上
+    alignas(64) std::atomic<uint64_t> head_;
+    alignas(64) std::atomic<uint64_t> tail_;
+};
+
+AsyncLogging::AsyncLogging(const std::string& basename, off_t rollSize, int flushInterval)
+    : basename_(basename), rollSize_(rollSize), flushInterval_(flushInterval),
+    id_(++g_numAsyncLogging), running_(false), wakeupPending_(false), dropped_(0),
+    thread_(std::bind(&AsyncLogging::threadFunc, this), "Logging"){
+
+}
+
+AsyncLogging::~AsyncLogging(){
+    if(running_){
+        stop();
+    }
+}
+
+void AsyncLogging::start(){
+    running_ = true;
+    thread_.start();
+}
+
+void AsyncLogging::stop(){
+    if(running_.exchange(false)){
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.notify_one();
+        }
+        thread_.join();
+    }
+}
+
+AsyncLogging::LogRing* AsyncLogging::currentThreadRing(){
+    static thread_local uint64_t t_ownerId = 0;
+    static thread_local LogRingPtr t_ring;
+    if(t_ownerId != id_){
+        t_ring = std::make_shared<LogRing>();
+        t_ownerId = id_;
+        std::unique_lock<std::mutex> lock(mutex_);
+        rings_.push_back(t_ring);
+    }
+    return t_ring.get();
+}
+
+void AsyncLogging::append(const char* logline, size_t len){
+    bool full = false;
+    bool needWakeup = currentThreadRing()->push(logline, len, &full);
+    if(full){
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if(needWakeup && !wakeupPending_.exchange(true)){
+        std::unique_lock<std::mutex> lock(mutex_);
+        cond_.notify_one();
+    }
+}
+
+void AsyncLogging::threadFunc(){
+    LogFile output(basename_, rollSize_);
+    std::vector<LogRingPtr> rings;
+    uint64_t reportedDropped = 0;
+
+    bool running = true;
+    while(running){
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            //必须在锁内读running_，否则stop()的notify可能落在读取与wait之间而丢失
+            running = running_;
+            if(running && !wakeupPending_){
+                cond_.wait_for(lock, std::chrono::seconds(flushInterval_));
+            }
+            wakeupPending_ = false;
+
+            //写日志的线程已经退出且数据已写完的ring，可以释放了
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [](const LogRingPtr& ring){
+                return ring.use_count() == 1 && ring->empty();
+            }), rings_.end());
+            rings = rings_;
+        }
+
+        for(const LogRingPtr& ring : rings){
+            ring->drain(&output);
+        }
+        rings.clear();
+
+        uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if(dropped != reportedDropped){
+            char buf[64];
+            int n = snprintf(buf, sizeof buf, "AsyncLogging dropped %" PRIu64 " lines\n", dropped - reportedDropped);
+            output.append(buf, n);
+            reportedDropped = dropped;
+        }
+        output.flush();
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Thread.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+/**
+ * 异步日志后端。前台线程append只写自己线程的无锁环形缓冲，后台线程批量写入滚动文件
+ * 用法：
+ *     AsyncLogging log("server", 500 * 1000 * 1000);
+ *     log.start();
+ *     Logger::getInstance().setOutput(std::bind(&AsyncLogging::append, &log, _1, _2));
+ *     Logger::getInstance().setFlush(std::bind(&AsyncLogging::stop, &log));
+*/
+class AsyncLogging : noncopyable{
+public:
+    AsyncLogging(const std::string& basename, off_t rollSize, int flushInterval = 1);
+    ~AsyncLogging();
+
+    //任意线程调用，快路径无锁。环形缓冲写满时丢弃这条日志并计数，绝不阻塞调用线程
+    void append(const char* logline, size_t len);
+
+    void start();
+    //把所有线程缓冲里剩下的日志写完再退出后台线程
+    void stop();
+
+    uint64_t droppedLines() const{
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+private:
+    class LogRing;
+    using LogRingPtr = std::shared_ptr<LogRing>;
+
+    static const size_t kRingSize = 1024 * 1024;
+
+    LogRing* currentThreadRing();
+    void threadFunc();
+
+    const std::string basename_;
+    const off_t rollSize_;
+    const int flushInterval_;
+    //区分不同的AsyncLogging实例，线程局部缓存的ring只属于一个实例
+    const uint64_t id_;
+
+    std::atomic_bool running_;
+    std::atomic_bool wakeupPending_;
+    std::atomic<uint64_t> dropped_;
+
+    Thread thread_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<LogRingPtr> rings_;
+};
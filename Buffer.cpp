@@ -1,5 +1,7 @@
 #include "Buffer.h"
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
 #include <sys/uio.h>
 #include <unistd.h>
 
@@ -16,11 +18,177 @@
  *             够：把待读数据挪动到开头，把空白区合并即可
  * 
  * 注：我们使用的容量，应该看size，而非capacity。
+ * 
+ * readFd：readv到【可写区 + extrabuf】，一次系统调用读尽量多的数据，读到extrabuf的部分再append。
+ *         extrabuf由TcpConnection传入所属loop共享的64K溢出缓冲，不再每次在栈上清零64K
+ * 
+ * prepend：写进readIndex_前面的空白区，一般是kCheapPrepend留出的8字节，用来在已经写好的消息体前补协议头而不搬动消息体。
+ *            空白区不够（或者还没分配存储）时换一块前面留够空间的存储
+ * 
+ * 链式模式（setChained）：数据存放在deque<Slab>里，每块slab固定kSlabSize，各自有读写下标
+ *            append：先填满最后一块slab，剩下的放进新slab，已有数据永远不搬动
+ *            retrieve：从前往后消费，读空的slab直接释放
+ *            writeFd：把所有slab的可读区间组成iovec，一次writev发出（最多IOV_MAX段）
+ *            peek：解析器需要连续内存时，把多块slab合并成一块。输出缓冲一般只走writeFd + retrieve，不会触发合并
+ * 
+ * 池化（Buffer(BufferPool*)构造）：存储（连续模式的vector、链式模式的每块slab）都从所属loop的BufferPool取
+ *            构造时不分配，第一次写入才取；retrieveAll读空后立刻归还，扩容时换一块更大的并归还旧块
+ *            shrink：长大的Buffer里只剩少量数据时，换一块刚好够用的小块，大块交给pool（pool不缓存大块，直接释放）
 */
 
+const size_t Buffer::kCheapPrepend;
+const size_t Buffer::kInitialSize;
+const size_t Buffer::kSlabSize;
+
+void Buffer::setChained(bool on){
+    if(on == chained_ || readableBytes() != 0){
+        return;
+    }
+    retrieveAll();
+    chained_ = on;
+    if(on){
+        if(pool_ != nullptr){
+            pool_->release(buffer_);
+        }else{
+            std::vector<char>().swap(buffer_);
+        }
+        readIndex_ = writeIndex_ = 0;
+    }else if(pool_ == nullptr){
+        buffer_.resize(kCheapPrepend + kInitialSize);
+        readIndex_ = writeIndex_ = kCheapPrepend;
+    }
+}
+
+Buffer::Storage::Storage(Storage&& rhs) noexcept
+    : block(std::move(rhs.block)), readIndex(rhs.readIndex), writeIndex(rhs.writeIndex), pool(rhs.pool){
+    rhs.block.clear();
+    rhs.readIndex = rhs.writeIndex = 0;
+}
+
+Buffer::Storage::~Storage(){
+    if(pool != nullptr){
+        pool->release(block);
+    }
+}
+
+Buffer::Buffer(Storage&& storage):
+    readIndex_(storage.readIndex), writeIndex_(storage.writeIndex), pool_(storage.pool), chained_(false), chainReadable_(0){
+    buffer_.swap(storage.block);
+    storage.readIndex = storage.writeIndex = 0;
+}
+
+Buffer::Storage Buffer::takeStorage(){
+    Storage storage;
+    storage.pool = pool_;
+    if(chained_){
+        return storage;
+    }
+    storage.block.swap(buffer_);
+    storage.readIndex = readIndex_;
+    storage.writeIndex = writeIndex_;
+    readIndex_ = writeIndex_ = 0;
+    //原来不带pool的Buffer交出存储后也变成懒分配，下次写入时makeSpace会重新分配
+    return storage;
+}
+
+Buffer::~Buffer(){
+    if(pool_ != nullptr){
+        retrieveAll();
+    }
+}
+
+size_t Buffer::internalCapacity() const{
+    if(chained_){
+        size_t total = 0;
+        for(const Slab& slab : slabs_){
+            total += slab.capacity;
+        }
+        return total;
+    }
+    return buffer_.size();
+}
+
+void Buffer::shrink(size_t reserve){
+    if(chained_){
+        return;
+    }
+    size_t readable = readableBytes();
+    if(readable == 0 && pool_ != nullptr){
+        retrieveAll();
+        return;
+    }
+    BufferPool::Block block = allocate(kCheapPrepend + readable + reserve);
+    std::copy(peek(), peek() + readable, block.begin() + kCheapPrepend);
+    if(pool_ != nullptr){
+        pool_->release(buffer_);
+    }
+    buffer_.swap(block);
+    readIndex_ = kCheapPrepend;
+    writeIndex_ = readIndex_ + readable;
+}
+
+BufferPool::Block Buffer::allocate(size_t size) const{
+    if(pool_ != nullptr){
+        return pool_->acquire(size);
+    }
+    return BufferPool::Block(size);
+}
+
+void Buffer::releaseSlabFront() const{
+    if(pool_ != nullptr){
+        pool_->release(slabs_.front().data);
+    }
+    slabs_.pop_front();
+}
+
+void Buffer::pooledMakeSpace(size_t len){
+    size_t readable = readableBytes();
+    //prepend之后readIndex_可能小于kCheapPrepend，不能先减kCheapPrepend，否则无符号下溢
+    if(!buffer_.empty() && readIndex_ + writeableBytes() >= kCheapPrepend + len){
+        //目标可能在源之后（readIndex_ < kCheapPrepend），区间重叠，用memmove
+        memmove(begin() + kCheapPrepend, begin() + readIndex_, readable);
+    }else{
+        BufferPool::Block block = allocate(kCheapPrepend + readable + len);
+        std::copy(buffer_.begin() + readIndex_, buffer_.begin() + writeIndex_, block.begin() + kCheapPrepend);
+        if(pool_ != nullptr){
+            pool_->release(buffer_);
+        }
+        buffer_.swap(block);
+    }
+    readIndex_ = kCheapPrepend;
+    writeIndex_ = readIndex_ + readable;
+}
+
+void Buffer::prepend(const void* data, size_t len){
+    if(chained_){
+        chainPrepend(static_cast<const char*>(data), len);
+        return;
+    }
+    if(buffer_.empty() || prependableBytes() < len){
+        size_t readable = readableBytes();
+        BufferPool::Block block = allocate(kCheapPrepend + len + readable);
+        std::copy(buffer_.begin() + readIndex_, buffer_.begin() + writeIndex_, block.begin() + kCheapPrepend + len);
+        if(pool_ != nullptr){
+            pool_->release(buffer_);
+        }
+        buffer_.swap(block);
+        readIndex_ = kCheapPrepend + len;
+        writeIndex_ = readIndex_ + readable;
+    }
+    readIndex_ -= len;
+    memcpy(begin() + readIndex_, data, len);
+}
+
+ssize_t Buffer::readFd(int fd, int* saveErrno){
+    char extrabuf[65536];
+    return readFd(fd, saveErrno, extrabuf, sizeof extrabuf);
+}
 
-size_t Buffer::readFd(int fd, int* saveErrno){
-    char extrabuf[65536] = {0};
+ssize_t Buffer::readFd(int fd, int* saveErrno, char* extrabuf, size_t extrabufSize){
+    if(chained_){
+        return chainReadFd(fd, saveErrno, extrabuf, extrabufSize);
+    }
+    //还没有存储的懒分配Buffer直接读进extrabuf，读到数据再按实际大小分配
     struct iovec vec[2];
 
     const size_t writable = writeableBytes();
@@ -29,14 +197,14 @@ size_t Buffer::readFd(int fd, int* saveErrno){
     vec[0].iov_len = writable;
 
     vec[1].iov_base = extrabuf;
-    vec[1].iov_len = sizeof extrabuf;
+    vec[1].iov_len = extrabufSize;
 
-    const int iovcnt = writable < sizeof(extrabuf) ? 2 : 1;
-    const size_t n = ::readv(fd, vec, iovcnt);
+    const int iovcnt = writable < extrabufSize ? 2 : 1;
+    const ssize_t n = ::readv(fd, vec, iovcnt);
 
     if(n < 0){
         *saveErrno = errno;
-    }else if(n <= writable){
+    }else if(static_cast<size_t>(n) <= writable){
         writeIndex_ += n;
     }else{
         writeIndex_ = buffer_.size();
@@ -45,10 +213,130 @@ size_t Buffer::readFd(int fd, int* saveErrno){
     return n;
 }
 
-size_t Buffer::writeFd(int fd, int* saveErrno){
-    size_t n = ::write(fd, peek(), readableBytes());
+ssize_t Buffer::writeFd(int fd, int* saveErrno){
+    if(chained_){
+        return chainWriteFd(fd, saveErrno);
+    }
+    ssize_t n = ::write(fd, peek(), readableBytes());
+    if(n < 0){
+        *saveErrno = errno;
+    }
+    return n;
+}
+
+const char* Buffer::chainPeek()const{
+    while(!slabs_.empty() && slabs_.front().readIndex == slabs_.front().writeIndex && slabs_.size() > 1){
+        releaseSlabFront();
+    }
+    if(slabs_.empty()){
+        return "";
+    }
+    if(slabs_.front().writeIndex - slabs_.front().readIndex < chainReadable_){
+        Slab merged(allocate(std::max(chainReadable_, kSlabSize)));
+        for(const Slab& slab : slabs_){
+            size_t n = slab.writeIndex - slab.readIndex;
+            memcpy(merged.data.data() + merged.writeIndex, slab.data.data() + slab.readIndex, n);
+            merged.writeIndex += n;
+        }
+        while(!slabs_.empty()){
+            releaseSlabFront();
+        }
+        slabs_.push_back(std::move(merged));
+    }
+    return slabs_.front().data.data() + slabs_.front().readIndex;
+}
+
+void Buffer::chainRetrieve(size_t len){
+    if(len >= chainReadable_){
+        retrieveAll();
+        return;
+    }
+    chainReadable_ -= len;
+    while(len > 0){
+        Slab& front = slabs_.front();
+        size_t n = std::min(len, front.writeIndex - front.readIndex);
+        front.readIndex += n;
+        len -= n;
+        if(front.readIndex == front.writeIndex){
+            releaseSlabFront();
+        }
+    }
+}
+
+void Buffer::chainAppend(const char* data, size_t len){
+    chainReadable_ += len;
+    if(!slabs_.empty()){
+        Slab& back = slabs_.back();
+        size_t n = std::min(len, back.capacity - back.writeIndex);
+        memcpy(back.data.data() + back.writeIndex, data, n);
+        back.writeIndex += n;
+        data += n;
+        len -= n;
+    }
+    if(len > 0){
+        slabs_.emplace_back(allocate(std::max(len, kSlabSize)));
+        memcpy(slabs_.back().data.data(), data, len);
+        slabs_.back().writeIndex = len;
+    }
+}
+
+void Buffer::chainPrepend(const char* data, size_t len){
+    if(slabs_.empty() || slabs_.front().readIndex < len){
+        //新slab的数据放在末尾，前面留给之后的prepend
+        Slab slab(allocate(std::max(len, kSlabSize)));
+        slab.readIndex = slab.writeIndex = slab.capacity;
+        slabs_.push_front(std::move(slab));
+    }
+    Slab& front = slabs_.front();
+    front.readIndex -= len;
+    memcpy(front.data.data() + front.readIndex, data, len);
+    chainReadable_ += len;
+}
+
+ssize_t Buffer::chainReadFd(int fd, int* saveErrno, char* extrabuf, size_t extrabufSize){
+    if(slabs_.empty() || slabs_.back().writeIndex == slabs_.back().capacity){
+        slabs_.emplace_back(allocate(kSlabSize));
+    }
+    Slab& back = slabs_.back();
+    const size_t writable = back.capacity - back.writeIndex;
+
+    struct iovec vec[2];
+    vec[0].iov_base = back.data.data() + back.writeIndex;
+    vec[0].iov_len = writable;
+    vec[1].iov_base = extrabuf;
+    vec[1].iov_len = extrabufSize;
+
+    const ssize_t n = ::readv(fd, vec, 2);
+    if(n < 0){
+        *saveErrno = errno;
+    }else if(static_cast<size_t>(n) <= writable){
+        back.writeIndex += n;
+        chainReadable_ += n;
+    }else{
+        back.writeIndex = back.capacity;
+        chainReadable_ += writable;
+        chainAppend(extrabuf, n - writable);
+    }
+    return n;
+}
+
+ssize_t Buffer::chainWriteFd(int fd, int* saveErrno){
+    struct iovec vec[IOV_MAX];
+    int iovcnt = 0;
+    for(Slab& slab : slabs_){
+        if(iovcnt == IOV_MAX){
+            break;
+        }
+        size_t n = slab.writeIndex - slab.readIndex;
+        if(n > 0){
+            vec[iovcnt].iov_base = slab.data.data() + slab.readIndex;
+            vec[iovcnt].iov_len = n;
+            ++iovcnt;
+        }
+    }
+    const ssize_t n = ::writev(fd, vec, iovcnt);
     if(n < 0){
         *saveErrno = errno;
     }
     return n;
-}
\ No newline at end of file
+}
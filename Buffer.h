@@ -1,36 +1,120 @@
 #pragma once
 #include <vector>
+#include <deque>
+#include <memory>
 #include <string>
 #include <algorithm>
+#include <string.h>
+#include <sys/types.h>
+
+#include "BufferPool.h"
 
 class Buffer{
 public:
     static const size_t kCheapPrepend = 8;
     static const size_t kInitialSize = 1024;
+    //链式模式下每块slab的大小，单次append超过它的数据会单独分配一块刚好装得下的slab
+    static const size_t kSlabSize = 16 * 1024;
 
     explicit Buffer(size_t initialSize = kInitialSize):
-        buffer_(kCheapPrepend + initialSize), readIndex_(kCheapPrepend), writeIndex_(kCheapPrepend){
+        buffer_(kCheapPrepend + initialSize), readIndex_(kCheapPrepend), writeIndex_(kCheapPrepend),
+        pool_(nullptr), chained_(false), chainReadable_(0){
+
+    }
+
+    //懒分配：构造时不分配存储，第一次写入时从pool取，读空后归还pool。pool为nullptr时直接new，不归还
+    explicit Buffer(BufferPool* pool):
+        readIndex_(0), writeIndex_(0), pool_(pool), chained_(false), chainReadable_(0){
+
+    }
+
+    //从连续模式的Buffer里取出的存储和读写位置，只能移动，析构时把块还给原来的pool。
+    //Buffer本身放不进Task的内联缓冲，跨线程投递时带这个就够了
+    struct Storage{
+        Storage() : readIndex(0), writeIndex(0), pool(nullptr){}
+        Storage(Storage&& rhs) noexcept;
+        Storage(const Storage&) = delete;
+        Storage& operator=(const Storage&) = delete;
+        ~Storage();
+
+        BufferPool::Block block;
+        size_t readIndex;
+        size_t writeIndex;
+        BufferPool* pool;
+    };
+
+    //接管takeStorage()取出的存储，pool沿用原来的
+    explicit Buffer(Storage&& storage);
+
+    ~Buffer();
+
+    BufferPool* pool() const{
+        return pool_;
+    }
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    //交换存储和模式，O(1)。两个Buffer的pool必须属于同一个loop
+    void swap(Buffer& rhs){
+        buffer_.swap(rhs.buffer_);
+        std::swap(readIndex_, rhs.readIndex_);
+        std::swap(writeIndex_, rhs.writeIndex_);
+        std::swap(pool_, rhs.pool_);
+        std::swap(chained_, rhs.chained_);
+        slabs_.swap(rhs.slabs_);
+        std::swap(chainReadable_, rhs.chainReadable_);
+    }
+
+    //交出存储，自己变成空的懒分配Buffer。只能在非链式模式下调用
+    Storage takeStorage();
+
+    //当前占用的存储字节数（不含pool里缓存的）
+    size_t internalCapacity() const;
+
+    //把存储缩到 可读数据 + reserve，释放长大后多余的内存
+    void shrink(size_t reserve);
 
+    //切换为slab链模式：append不再搬动已有数据，writeFd一次writev发出整条链。只能在buffer为空时切换
+    void setChained(bool on);
+
+    bool chained() const{
+        return chained_;
     }
 
     size_t readableBytes()const{
+        if(chained_){
+            return chainReadable_;
+        }
         return writeIndex_ - readIndex_;
     }
 
     size_t writeableBytes()const{
+        if(chained_){
+            return slabs_.empty() ? 0 : slabs_.back().capacity - slabs_.back().writeIndex;
+        }
         return buffer_.size() - writeIndex_;
     }
 
     size_t prependableBytes()const{
+        if(chained_){
+            return slabs_.empty() ? 0 : slabs_.front().readIndex;
+        }
         return readIndex_;
     }
 
+    //链式模式下若数据跨了多块slab，会先合并成一块再返回，保证返回的可读区间连续
     const char* peek()const{
+        if(chained_){
+            return chainPeek();
+        }
         return begin() + readIndex_;
     }
 
     void retrieve(size_t len){
-        if(len < readableBytes()){
+        if(chained_){
+            chainRetrieve(len);
+        }else if(len < readableBytes()){
             readIndex_ += len;
         }else{
             retrieveAll();
@@ -54,49 +138,108 @@ public:
     }
 
     void append(const char* data, size_t len){
+        if(chained_){
+            chainAppend(data, len);
+            return;
+        }
         ensureWriteableBytes(len);
         std::copy(data, data + len, beginWrite());
         writeIndex_ += len;
     }
 
 
+    //写到可读数据前面，用掉kCheapPrepend预留的空间（如协议头），不搬动已有数据。预留空间不够时才重新分配
+    void prepend(const void* data, size_t len);
+
     char* beginWrite(){
+        if(chained_){
+            return slabs_.back().data.data() + slabs_.back().writeIndex;
+        }
         return begin() + writeIndex_;
     }
 
     const char* beginRead()const{
-        return begin() + readIndex_;
+        return peek();
     }
 
-    size_t readFd(int fd, int* saveErrno);
+    ssize_t readFd(int fd, int* saveErrno);
 
-    size_t writeFd(int fd, int* saveErrno);
+    //extrabuf：可写区放不下的数据先读到这里再append，由调用方提供（一般是所属loop共享的溢出缓冲），不需要清零
+    ssize_t readFd(int fd, int* saveErrno, char* extrabuf, size_t extrabufSize);
+
+    ssize_t writeFd(int fd, int* saveErrno);
 
     void retrieveAll(){
-        readIndex_ = writeIndex_ = kCheapPrepend;
+        if(chained_){
+            while(!slabs_.empty()){
+                releaseSlabFront();
+            }
+            chainReadable_ = 0;
+            return;
+        }
+        if(pool_ != nullptr){
+            pool_->release(buffer_);
+            readIndex_ = writeIndex_ = 0;
+            return;
+        }
+        readIndex_ = writeIndex_ = buffer_.empty() ? 0 : kCheapPrepend;
     }
 
 private:
+    struct Slab{
+        explicit Slab(BufferPool::Block block) : data(std::move(block)), capacity(data.size()), readIndex(0), writeIndex(0){}
+        BufferPool::Block data;
+        size_t capacity;
+        size_t readIndex;
+        size_t writeIndex;
+    };
 
     void makeSpace(size_t len){
-        if(writeableBytes() + prependableBytes() - kCheapPrepend < len){
+        if(chained_){
+            slabs_.emplace_back(allocate(std::max(len, kSlabSize)));
+            return;
+        }
+        if(pool_ != nullptr || buffer_.empty()){
+            pooledMakeSpace(len);
+            return;
+        }
+        //readIndex_在prepend之后可能小于kCheapPrepend，比较时不做减法
+        if(readIndex_ + writeableBytes() < kCheapPrepend + len){
             buffer_.resize(writeIndex_ + len);
         }else{
             size_t readable = readableBytes();
-            std::copy(buffer_.begin() + readIndex_, buffer_.begin() + writeIndex_, buffer_.begin() + kCheapPrepend);
+            memmove(begin() + kCheapPrepend, begin() + readIndex_, readable);
             readIndex_ = kCheapPrepend;
             writeIndex_ = readIndex_ + readable;
         }
     }
 
+    const char* chainPeek()const;
+    void chainRetrieve(size_t len);
+    void chainAppend(const char* data, size_t len);
+    void chainPrepend(const char* data, size_t len);
+    ssize_t chainReadFd(int fd, int* saveErrno, char* extrabuf, size_t extrabufSize);
+    ssize_t chainWriteFd(int fd, int* saveErrno);
+    void releaseSlabFront() const;
+
+    void pooledMakeSpace(size_t len);
+    BufferPool::Block allocate(size_t size) const;
+
     char* begin(){
-        return &*buffer_.begin();
+        return buffer_.data();
     }
 
     const char* begin()const{
-        return &*buffer_.begin();
+        return buffer_.data();
     }
     std::vector<char> buffer_;
     size_t readIndex_;
     size_t writeIndex_;
-};
\ No newline at end of file
+
+    BufferPool* pool_;
+
+    bool chained_;
+    //peek需要合并slab，所以是mutable
+    mutable std::deque<Slab> slabs_;
+    size_t chainReadable_;
+};
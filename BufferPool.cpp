@@ -0,0 +1,68 @@
+#include "BufferPool.h"
+#include "EventLoop.h"
+
+/**
+ * BufferPool：按 2K / 16K / 64K / 256K 四级缓存空闲内存块，freeLists_[i]保存第i级的空闲块
+ * acquire：向上取整到所在级别，有空闲块就直接拿走，没有再分配；超过最大级别的按需分配，不缓存。
+ *          不在所属loop线程调用时不碰空闲链表，直接分配
+ * release：只有大小正好等于某一级的块才会被缓存，并且每级缓存有上限。
+ *          Buffer扩容出来的大块、超过上限的块都直接释放，这就是长大的Buffer的收缩策略：读空即归还，大块不留
+ * 
+ * 配合Buffer(BufferPool*)使用：连接的Buffer第一次写入时才向池子要存储，读空后立刻归还，空闲连接不占Buffer内存
+*/
+
+namespace{
+    const size_t kClassSizes[BufferPool::kNumClasses] = {
+        2 * 1024, 16 * 1024, 64 * 1024, 256 * 1024
+    };
+}
+
+BufferPool::BufferPool(EventLoop* loop) : loop_(loop), bytesHeld_(0), bytesCached_(0){
+
+}
+
+int BufferPool::sizeClass(size_t size){
+    for(int i = 0; i < kNumClasses; ++i){
+        if(size <= kClassSizes[i]){
+            return i;
+        }
+    }
+    return -1;
+}
+
+BufferPool::Block BufferPool::acquire(size_t size){
+    Block block;
+    int c = sizeClass(size);
+    if(c < 0){
+        block.resize(size);
+    }else if(!loop_->isInLoopThread()){
+        //别的线程拿着这个pool的Buffer（比如跨线程send过来的Buffer被peek合并），不能碰freeLists_，直接分配
+        block.resize(kClassSizes[c]);
+    }else if(!freeLists_[c].empty()){
+        block.swap(freeLists_[c].back());
+        freeLists_[c].pop_back();
+        bytesCached_.fetch_sub(block.size(), std::memory_order_relaxed);
+    }else{
+        block.resize(kClassSizes[c]);
+    }
+    bytesHeld_.fetch_add(block.size(), std::memory_order_relaxed);
+    return block;
+}
+
+void BufferPool::release(Block& block){
+    size_t size = block.size();
+    if(size == 0){
+        return;
+    }
+    bytesHeld_.fetch_sub(size, std::memory_order_relaxed);
+
+    int c = sizeClass(size);
+    if(c >= 0 && size == kClassSizes[c] && loop_->isInLoopThread()
+        && (freeLists_[c].size() + 1) * size <= kMaxCachedBytesPerClass){
+        freeLists_[c].emplace_back();
+        freeLists_[c].back().swap(block);
+        bytesCached_.fetch_add(size, std::memory_order_relaxed);
+    }else{
+        Block().swap(block);
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "noncopyable.h"
+#include <vector>
+#include <atomic>
+#include <stddef.h>
+
+class EventLoop;
+
+/**
+ * 每个EventLoop一个的Buffer存储池，按大小分级缓存空闲的内存块
+ * 空闲链表只在所属loop线程访问，不加锁，别的线程acquire/release退化为普通分配/释放；统计值是原子变量，任意线程可读
+*/
+class BufferPool : noncopyable{
+public:
+    using Block = std::vector<char>;
+
+    static const int kNumClasses = 4;
+    //每一级最多缓存这么多字节，多出来的直接释放
+    static const size_t kMaxCachedBytesPerClass = 4 * 1024 * 1024;
+
+    explicit BufferPool(EventLoop* loop);
+
+    //返回的block.size() >= size。不在所属loop线程调用时直接分配，不走空闲链表
+    Block acquire(size_t size);
+    //block交还给池子后被置空。不在所属loop线程调用时直接释放
+    void release(Block& block);
+
+    //当前被Buffer持有的字节数。读空的Buffer会立刻归还存储，所以这就是有未处理数据的连接占用的内存
+    size_t bytesHeld() const{
+        return bytesHeld_.load(std::memory_order_relaxed);
+    }
+
+    //池子里缓存、尚未分配出去的字节数
+    size_t bytesCached() const{
+        return bytesCached_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static int sizeClass(size_t size);
+
+    EventLoop* loop_;
+    std::vector<Block> freeLists_[kNumClasses];
+    std::atomic<size_t> bytesHeld_;
+    std::atomic<size_t> bytesCached_;
+};
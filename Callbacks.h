@@ -2,14 +2,20 @@
 
 #include <memory>
 #include <functional>
+#include <string>
+#include "Task.h"
 
 class Buffer;
 class TcpConnection;
 class TimeStamp;
 
 using TcpConnectionPtr = std::shared_ptr<TcpConnection>;
+//调用方交出所有权的只读数据，发送期间由连接共享持有
+using SharedPayload = std::shared_ptr<const std::string>;
 using ConnectionCallback = std::function<void (const TcpConnectionPtr&)>;
 using CloseCallback = std::function<void(const TcpConnectionPtr&)>;
 using WriteCompleteCallback = std::function<void(const TcpConnectionPtr&)>;
 using MessageCallback = std::function<void (const TcpConnectionPtr&, Buffer*, TimeStamp)>;
-using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
\ No newline at end of file
+using HighWaterMarkCallback = std::function<void(const TcpConnectionPtr&, size_t)>;
+//定时器回调只由Timer持有，用只能移动的Task，不要求可拷贝
+using TimerCallback = Task;
@@ -7,6 +7,9 @@
 const int Channel::kNoneEvent = 0;
 const int Channel::kReadEvent = EPOLLIN | EPOLLPRI;
 const int Channel::kWriteEvent = EPOLLOUT;
+const int Channel::kEdgeTriggered = EPOLLET;
+const int Channel::kExclusive = EPOLLEXCLUSIVE;
+const int Channel::kPriEvent = EPOLLPRI;
 
 /**
  * Channel: 主要维护了tie<void> tied、events、revents
@@ -20,12 +23,14 @@ const int Channel::kWriteEvent = EPOLLOUT;
  *      channel update自己的事件：TcpConnection中新建立的Channel，只有在调用disableAll等更新函数后，才会被自动添加到Epoll和它的Map中
  *      channel update自己
  *      channel remove自己
+ *      边沿触发模式下注册的事件固定不变，enable/disable只修改events_，不会走到epoll；
+ *      逻辑事件全部关掉也不从epoll删除，只有disableAll和remove才真正注销
  *      
 */
 
 
 Channel::Channel(EventLoop* loop, int fd)
-    : loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), tied_(false)
+    : loop_(loop), fd_(fd), events_(0), revents_(0), index_(-1), edgeTriggered_(false), exclusive_(false), edgeRegistered_(false), registeredEvents_(kNoneEvent), tied_(false)
 {
 
 }
@@ -36,10 +41,19 @@ void Channel::tie(const std::shared_ptr<void>& obj){
 }
 
 void Channel::update(){
+    if(edgeTriggered_){
+        edgeRegistered_ = edgeRegistered_ || events_ != kNoneEvent;
+        if(events() == registeredEvents_){
+            return;
+        }
+    }
+    registeredEvents_ = events();
     loop_->updateChannel(this);
 }
 
 void Channel::remove(){
+    edgeRegistered_ = false;
+    registeredEvents_ = kNoneEvent;
     loop_->removeChannel(this);
 }
 
@@ -55,7 +69,7 @@ void Channel::handleEvent(TimeStamp receiveTime){
 }
 
 void Channel::handleEventWithGuard(TimeStamp receiveTime){
-    LOG_INFO("channel handleEvents: %d\n", revents_);
+    LOG_DEBUG("channel handleEvents: %d\n", revents_);
     if((revents_ & EPOLLHUP) && !(revents_ & EPOLLIN)){
         if(closeCallback_){
             closeCallback_();
@@ -66,12 +80,13 @@ void Channel::handleEventWithGuard(TimeStamp receiveTime){
             errorCallback_();
         }
     }
-    if(revents_ & (EPOLLIN | EPOLLPRI)){
+    //边沿触发时读写事件一直注册着，只分发逻辑上关注的
+    if((revents_ & (EPOLLIN | EPOLLPRI)) && (!edgeTriggered_ || isReading())){
         if(readCallback_){
             readCallback_(receiveTime);
         }
     }
-    if(revents_ & EPOLLOUT){
+    if((revents_ & EPOLLOUT) && (!edgeTriggered_ || isWriting())){
         if(writeCallback_){
             writeCallback_();
         }
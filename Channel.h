@@ -34,16 +34,41 @@ public:
         return fd_; 
     }
 
+    //交给poller注册的事件。边沿触发时从第一次关注事件起就固定注册读+写+EPOLLET，
+    //之后逻辑上不关注任何事件（如只stopRead）也保持注册，直到disableAll/remove
     int events()const{
+        if(edgeTriggered_ && (events_ != kNoneEvent || edgeRegistered_)){
+            return kReadEvent | kWriteEvent | kEdgeTriggered;
+        }
+        if(exclusive_ && events_ != kNoneEvent){
+            //EPOLLEXCLUSIVE不能和EPOLLPRI一起用
+            return (events_ & ~kPriEvent) | kExclusive;
+        }
         return events_;
     }
 
+    //边沿触发模式：enable/disable读写只改变逻辑上关注的事件，不再调用epoll_ctl，只在加入和移除时各调用一次。
+    //回调方必须读/写到EAGAIN（或读/写不满）为止。需要在第一次enable之前设置
+    void setEdgeTriggered(bool on){
+        edgeTriggered_ = on;
+    }
+
+    bool edgeTriggered() const{
+        return edgeTriggered_;
+    }
+
+    //EPOLLEXCLUSIVE：多个loop监听同一个fd时，一个事件只唤醒其中一个。只能在加入epoll时指定，之后不能再修改关注的事件
+    void setExclusive(bool on){
+        exclusive_ = on;
+    }
+
     void set_revents(int revt){
         revents_ = revt;
     }
 
+    //poller看的是实际注册的事件：边沿触发时逻辑事件为空，fd也可能仍然注册着
     bool isNoneEvent(){
-        return events_ == kNoneEvent;
+        return events() == kNoneEvent;
     }
 
     void enableReading(){
@@ -68,6 +93,7 @@ public:
 
     void disableAll(){
         events_ = kNoneEvent;
+        edgeRegistered_ = false;
         update();
     }
 
@@ -99,6 +125,12 @@ private:
     int events_;
     int revents_;
     int index_;
+    bool edgeTriggered_;
+    bool exclusive_;
+    //边沿触发时fd已经按固定事件注册过
+    bool edgeRegistered_;
+    //最近一次交给poller的events()，边沿触发时没有变化就不更新
+    int registeredEvents_;
     
     std::weak_ptr<void> tie_;
     bool tied_;
@@ -111,6 +143,9 @@ private:
     static const int kNoneEvent;
     static const int kReadEvent;
     static const int kWriteEvent;
+    static const int kEdgeTriggered;
+    static const int kExclusive;
+    static const int kPriEvent;
 
     void update();
     void handleEventWithGuard(TimeStamp receiveTime);
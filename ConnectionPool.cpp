@@ -0,0 +1,179 @@
+#include "ConnectionPool.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <string.h>
+#include <sys/socket.h>
+
+/**
+ * ConnectionPool：维护了按上游地址分组的空闲连接idle_、所有连接connections_、正在连接的Connector
+ * acquire：从对应上游的空闲连接里从队尾取（最近用过的最“热”），跳过已经断开的；没有就用Connector新建，
+ *          Connector只重试connectRetries_次，最终失败回调空指针
+ * release：还回来的连接把回调换回池子的默认回调。release通常就在借用方自己的message回调里调用，当场替换会析构正在执行的回调，
+ *          所以放到本轮任务里再换，换之前检查连接没有又被借出去。
+ *          空闲期间收到数据说明协议已经错位（上一个请求的响应没读完，或对端主动推送），直接关闭；空闲期间对端关闭则由关闭回调从idle_里摘掉
+ * Connector在它自己的回调里不能被析构，交出fd之后放到queueInLoop里释放
+ * 析构：停掉所有Connector；空闲连接关闭；借出去的连接还在调用方手里，只把关闭回调换成不依赖this的版本
+*/
+
+const size_t ConnectionPool::kDefaultMaxIdlePerHost;
+
+static void removeDetachedConnection(const TcpConnectionPtr& conn){
+    conn->getLoop()->queueInLoop(std::bind(&TcpConnection::connectionDestroyed, conn));
+}
+
+static void dropConnector(const ConnectorPtr&){
+}
+
+ConnectionPool::ConnectionPool(EventLoop* loop, const std::string& name)
+    : loop_(loop), name_(name), maxIdlePerHost_(kDefaultMaxIdlePerHost), idleTimeout_(0.0),
+    connectRetries_(2), nextConnId_(1){
+}
+
+ConnectionPool::~ConnectionPool(){
+    for(auto& item : connecting_){
+        item.second->stop();
+    }
+    connecting_.clear();
+    for(auto& item : connections_){
+        item.second.conn->setCloseCallback(removeDetachedConnection);
+    }
+    for(auto& item : idle_){
+        for(const TcpConnectionPtr& conn : item.second){
+            conn->forceClose();
+        }
+    }
+}
+
+void ConnectionPool::checkInLoopThread() const{
+    if(!loop_->isInLoopThread()){
+        LOG_FATAL("%s:%s:%d ConnectionPool %s used outside its loop thread\n", __FILE__, __FUNCTION__, __LINE__, name_.c_str());
+    }
+}
+
+void ConnectionPool::acquire(const InetAddress& serverAddr, const AcquireCallback& cb){
+    checkInLoopThread();
+    auto it = idle_.find(serverAddr.toIpPort());
+    if(it != idle_.end()){
+        std::vector<TcpConnectionPtr>& conns = it->second;
+        while(!conns.empty()){
+            TcpConnectionPtr conn = std::move(conns.back());
+            conns.pop_back();
+            if(conn->connected()){
+                *connections_[conn->name()].idle = false;
+                cb(conn);
+                return;
+            }
+        }
+    }
+
+    ConnectorPtr connector(new Connector(loop_, serverAddr));
+    connector->setMaxRetries(connectRetries_);
+    connector->setNewConnectionCallback(std::bind(&ConnectionPool::newConnection, this, connector.get(), cb, std::placeholders::_1));
+    connector->setConnectFailedCallback(std::bind(&ConnectionPool::connectFailed, this, connector.get(), cb));
+    connecting_[connector.get()] = connector;
+    connector->start();
+}
+
+void ConnectionPool::release(const TcpConnectionPtr& conn){
+    checkInLoopThread();
+    auto it = connections_.find(conn->name());
+    if(it == connections_.end() || *it->second.idle || !conn->connected()){
+        return;
+    }
+    std::vector<TcpConnectionPtr>& conns = idle_[conn->peerAddress().toIpPort()];
+    if(conn->inputBuffer()->readableBytes() > 0){
+        LOG_INFO("ConnectionPool::release [%s] unread data, closing\n", conn->name().c_str());
+        conn->forceClose();
+    }else if(conns.size() >= maxIdlePerHost_){
+        conn->shutdown();
+    }else{
+        *it->second.idle = true;
+        conns.push_back(conn);
+        loop_->queueInLoop(std::bind(&ConnectionPool::restoreIdleCallbacks, conn, it->second.idle));
+    }
+}
+
+size_t ConnectionPool::idleConnections() const{
+    size_t n = 0;
+    for(const auto& item : idle_){
+        n += item.second.size();
+    }
+    return n;
+}
+
+void ConnectionPool::newConnection(Connector* connector, const AcquireCallback& cb, int sockfd){
+    AcquireCallback callback(cb);
+    releaseConnector(connector);
+
+    sockaddr_in local;
+    memset(&local, 0, sizeof local);
+    socklen_t addrlen = sizeof local;
+    if(::getsockname(sockfd, (sockaddr*)&local, &addrlen) < 0){
+        LOG_ERROR("sockets:getLocalAddr");
+    }
+    InetAddress localAddr(local);
+    InetAddress peerAddr(connector->serverAddress());
+
+    char buf[64] = {0};
+    snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_++);
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(new TcpConnection(loop_, connName, sockfd, localAddr, peerAddr));
+    conn->setConnectionCallback(idleConnectionCallback);
+    conn->setMessageCallback(idleMessageCallback);
+    conn->setIdleTimeout(idleTimeout_);
+    conn->setCloseCallback(std::bind(&ConnectionPool::removeConnection, this, std::placeholders::_1));
+    Entry& entry = connections_[connName];
+    entry.conn = conn;
+    entry.idle = std::make_shared<bool>(false);
+    conn->connectionEstablished();
+    callback(conn);
+}
+
+void ConnectionPool::connectFailed(Connector* connector, const AcquireCallback& cb){
+    AcquireCallback callback(cb);
+    LOG_ERROR("ConnectionPool::connectFailed [%s] to %s\n", name_.c_str(), connector->serverAddress().toIpPort().c_str());
+    releaseConnector(connector);
+    callback(TcpConnectionPtr());
+}
+
+void ConnectionPool::releaseConnector(Connector* connector){
+    auto it = connecting_.find(connector);
+    if(it != connecting_.end()){
+        //正在这个Connector的回调里，推迟到本轮任务里析构
+        loop_->queueInLoop(std::bind(&dropConnector, it->second));
+        connecting_.erase(it);
+    }
+}
+
+void ConnectionPool::removeConnection(const TcpConnectionPtr& conn){
+    connections_.erase(conn->name());
+    auto it = idle_.find(conn->peerAddress().toIpPort());
+    if(it != idle_.end()){
+        std::vector<TcpConnectionPtr>& conns = it->second;
+        conns.erase(std::remove(conns.begin(), conns.end(), conn), conns.end());
+    }
+    loop_->queueInLoop(std::bind(&TcpConnection::connectionDestroyed, conn));
+}
+
+void ConnectionPool::restoreIdleCallbacks(const TcpConnectionPtr& conn, const std::shared_ptr<bool>& idle){
+    if(!*idle){
+        return;
+    }
+    conn->setConnectionCallback(idleConnectionCallback);
+    conn->setMessageCallback(idleMessageCallback);
+    conn->setWriteCompleleCallback(WriteCompleteCallback());
+    conn->setHighWaterMarkCallback(HighWaterMarkCallback());
+}
+
+void ConnectionPool::idleConnectionCallback(const TcpConnectionPtr&){
+}
+
+void ConnectionPool::idleMessageCallback(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+    LOG_INFO("ConnectionPool idle connection [%s] got %lu bytes, closing\n", conn->name().c_str(), buf->readableBytes());
+    buf->retrieveAll();
+    conn->forceClose();
+}
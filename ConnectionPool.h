@@ -0,0 +1,81 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include "Connector.h"
+#include "InetAddress.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+class EventLoop;
+class TimeStamp;
+
+/**
+ * 单个loop的上游连接池：按上游地址缓存用完归还的TcpConnection，下次acquire直接复用，不用再握手。
+ * 连接只属于这个loop，acquire/release都只能在本loop线程调用，用的时候也不会跨线程。
+ * 多线程的服务在ThreadInitCallback里给每个subLoop各建一个
+*/
+class ConnectionPool : noncopyable{
+public:
+    //连接失败时conn为空
+    using AcquireCallback = std::function<void(const TcpConnectionPtr& conn)>;
+
+    ConnectionPool(EventLoop* loop, const std::string& name);
+    ~ConnectionPool();
+
+    //每个上游最多缓存多少个空闲连接，多出来的归还时直接关闭
+    void setMaxIdlePerHost(size_t n){
+        maxIdlePerHost_ = n;
+    }
+    //连接超过seconds没有读写就关闭，0表示不启用，只影响之后新建的连接
+    void setIdleTimeout(double seconds){
+        idleTimeout_ = seconds;
+    }
+    //新建连接失败后最多重试几次
+    void setConnectRetries(int retries){
+        connectRetries_ = retries;
+    }
+
+    //有空闲连接时当场回调，否则新建连接，连上或失败后回调。
+    //借出的连接由调用方设置自己的message等回调，用完release
+    void acquire(const InetAddress& serverAddr, const AcquireCallback& cb);
+    //归还连接。已经断开、还有没读完的数据或者空闲连接已满的不再缓存
+    void release(const TcpConnectionPtr& conn);
+
+    size_t idleConnections() const;
+    size_t connections() const{
+        return connections_.size();
+    }
+
+private:
+    static const size_t kDefaultMaxIdlePerHost = 16;
+
+    void newConnection(Connector* connector, const AcquireCallback& cb, int sockfd);
+    void connectFailed(Connector* connector, const AcquireCallback& cb);
+    void releaseConnector(Connector* connector);
+    void removeConnection(const TcpConnectionPtr& conn);
+    void checkInLoopThread() const;
+
+    //idle为true（连接仍在池里没被再次借出）才换回空闲时的回调
+    static void restoreIdleCallbacks(const TcpConnectionPtr& conn, const std::shared_ptr<bool>& idle);
+    static void idleConnectionCallback(const TcpConnectionPtr& conn);
+    static void idleMessageCallback(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime);
+
+    EventLoop* loop_;
+    const std::string name_;
+    size_t maxIdlePerHost_;
+    double idleTimeout_;
+    int connectRetries_;
+    int nextConnId_;
+    //上游ip:port -> 空闲连接，队尾是最近归还的
+    std::unordered_map<std::string, std::vector<TcpConnectionPtr>> idle_;
+    //本池建立的所有连接（空闲的和借出的）
+    struct Entry{
+        TcpConnectionPtr conn;
+        std::shared_ptr<bool> idle;
+    };
+    std::unordered_map<std::string, Entry> connections_;
+    //正在连接的Connector
+    std::unordered_map<Connector*, ConnectorPtr> connecting_;
+};
@@ -0,0 +1,213 @@
+#include "Connector.h"
+#include "Channel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+/**
+ * Connector：维护了一个只在connect进行中存在的channel_，和重试的退避时间
+ * connect：非阻塞socket直接connect。EINPROGRESS等表示正在连接，给channel_注册可写事件等结果；
+ *          ECONNREFUSED等暂时性错误关掉fd稍后重试；其他错误（地址不对、没有权限）重试也没用，直接放弃
+ * handleWrite：socket可写说明connect有了结果，先把channel_摘掉（fd之后交给TcpConnection，不能再被这个channel关注），
+ *          再用SO_ERROR取结果。连上了还要排除自连接（本机连本机、源端口恰好等于目的端口），然后交出fd
+ * retry：关fd，在retryDelayMs_之后再connect，每次翻倍，最多kMaxRetryDelayMs。超过maxRetries_就回调connectFailedCallback_
+ * 
+ * channel_是在自己的handleEvent里被摘掉的，不能当场析构，放到queueInLoop里reset
+*/
+
+const int Connector::kMaxRetryDelayMs;
+const int Connector::kInitRetryDelayMs;
+
+static int createNonblockingSocket(){
+    int sockfd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(sockfd < 0){
+        LOG_ERROR("%s:%s:%d socket create err:%d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+    }
+    return sockfd;
+}
+
+static int getSocketError(int sockfd){
+    int optval = 0;
+    socklen_t optlen = sizeof optval;
+    if(::getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &optval, &optlen) < 0){
+        return errno;
+    }
+    return optval;
+}
+
+static bool isSelfConnect(int sockfd){
+    sockaddr_in local, peer;
+    socklen_t len = sizeof local;
+    memset(&local, 0, sizeof local);
+    memset(&peer, 0, sizeof peer);
+    if(::getsockname(sockfd, (sockaddr*)&local, &len) < 0){
+        return false;
+    }
+    len = sizeof peer;
+    if(::getpeername(sockfd, (sockaddr*)&peer, &len) < 0){
+        return false;
+    }
+    return local.sin_port == peer.sin_port && local.sin_addr.s_addr == peer.sin_addr.s_addr;
+}
+
+Connector::Connector(EventLoop* loop, const InetAddress& serverAddr)
+    : loop_(loop), serverAddr_(serverAddr), connect_(false), state_(kDisconnected),
+    retryDelayMs_(kInitRetryDelayMs), maxRetries_(-1), retries_(0), retryScheduled_(false){
+    LOG_DEBUG("Connector ctor[%p]\n", this);
+}
+
+Connector::~Connector(){
+    LOG_DEBUG("Connector dtor[%p]\n", this);
+}
+
+void Connector::start(){
+    connect_ = true;
+    loop_->runInLoop(std::bind(&Connector::startInLoop, shared_from_this()));
+}
+
+void Connector::startInLoop(){
+    retryScheduled_ = false;
+    if(connect_ && state_ == kDisconnected){
+        connect();
+    }
+}
+
+void Connector::stop(){
+    connect_ = false;
+    loop_->runInLoop(std::bind(&Connector::stopInLoop, shared_from_this()));
+}
+
+void Connector::stopInLoop(){
+    if(retryScheduled_){
+        loop_->cancel(retryTimer_);
+        retryScheduled_ = false;
+    }
+    if(state_ == kConnecting){
+        int sockfd = removeAndResetChannel();
+        retry(sockfd);
+    }
+}
+
+void Connector::restart(){
+    setState(kDisconnected);
+    retryDelayMs_ = kInitRetryDelayMs;
+    retries_ = 0;
+    connect_ = true;
+    startInLoop();
+}
+
+void Connector::connect(){
+    int sockfd = createNonblockingSocket();
+    if(sockfd < 0){
+        retry(-1);
+        return;
+    }
+    int ret = ::connect(sockfd, (const sockaddr*)serverAddr_.getSockaddr(), sizeof(sockaddr_in));
+    int savedErrno = (ret == 0) ? 0 : errno;
+    switch(savedErrno){
+    case 0:
+    case EINPROGRESS:
+    case EINTR:
+    case EISCONN:
+        connecting(sockfd);
+        break;
+
+    case EAGAIN:
+    case EADDRINUSE:
+    case EADDRNOTAVAIL:
+    case ECONNREFUSED:
+    case ENETUNREACH:
+        retry(sockfd);
+        break;
+
+    default:
+        LOG_ERROR("%s:%s:%d connect %s err %d\n", __FILE__, __FUNCTION__, __LINE__,
+            serverAddr_.toIpPort().c_str(), savedErrno);
+        ::close(sockfd);
+        setState(kDisconnected);
+        if(connectFailedCallback_){
+            connectFailedCallback_();
+        }
+        break;
+    }
+}
+
+void Connector::connecting(int sockfd){
+    setState(kConnecting);
+    channel_.reset(new Channel(loop_, sockfd));
+    channel_->setWriteCallback(std::bind(&Connector::handleWrite, this));
+    channel_->setErrorCallback(std::bind(&Connector::handleError, this));
+    channel_->enableWriting();
+}
+
+int Connector::removeAndResetChannel(){
+    channel_->disableAll();
+    channel_->remove();
+    int sockfd = channel_->fd();
+    loop_->queueInLoop(std::bind(&Connector::resetChannel, shared_from_this()));
+    return sockfd;
+}
+
+void Connector::resetChannel(){
+    //期间可能又开始了新的connect，只释放已经摘掉的那个
+    if(state_ != kConnecting){
+        channel_.reset();
+    }
+}
+
+void Connector::handleWrite(){
+    if(state_ != kConnecting){
+        return;
+    }
+    int sockfd = removeAndResetChannel();
+    int err = getSocketError(sockfd);
+    if(err != 0){
+        LOG_INFO("Connector::handleWrite %s SO_ERROR = %d\n", serverAddr_.toIpPort().c_str(), err);
+        retry(sockfd);
+    }else if(isSelfConnect(sockfd)){
+        LOG_INFO("Connector::handleWrite %s self connect\n", serverAddr_.toIpPort().c_str());
+        retry(sockfd);
+    }else{
+        setState(kConnected);
+        if(connect_ && newConnectionCallback_){
+            newConnectionCallback_(sockfd);
+        }else{
+            ::close(sockfd);
+        }
+    }
+}
+
+void Connector::handleError(){
+    if(state_ == kConnecting){
+        int sockfd = removeAndResetChannel();
+        LOG_INFO("Connector::handleError %s SO_ERROR = %d\n", serverAddr_.toIpPort().c_str(), getSocketError(sockfd));
+        retry(sockfd);
+    }
+}
+
+void Connector::retry(int sockfd){
+    if(sockfd >= 0){
+        ::close(sockfd);
+    }
+    setState(kDisconnected);
+    if(!connect_){
+        return;
+    }
+    if(maxRetries_ >= 0 && retries_ >= maxRetries_){
+        connect_ = false;
+        if(connectFailedCallback_){
+            connectFailedCallback_();
+        }
+        return;
+    }
+    ++retries_;
+    LOG_INFO("Connector::retry connecting to %s in %d ms\n", serverAddr_.toIpPort().c_str(), retryDelayMs_);
+    retryTimer_ = loop_->runAfter(retryDelayMs_ / 1000.0, std::bind(&Connector::startInLoop, shared_from_this()));
+    retryScheduled_ = true;
+    retryDelayMs_ = std::min(retryDelayMs_ * 2, kMaxRetryDelayMs);
+}
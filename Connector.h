@@ -0,0 +1,80 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "InetAddress.h"
+#include "TimerId.h"
+#include <functional>
+#include <memory>
+#include <atomic>
+
+class Channel;
+class EventLoop;
+
+/**
+ * 主动发起连接：非阻塞connect，EINPROGRESS时等socket可写再用SO_ERROR判断结果，失败按指数退避重试。
+ * 连接建立后把sockfd交给newConnectionCallback_，之后就不再管这个fd。除start/stop外只在loop线程调用
+*/
+class Connector : noncopyable, public std::enable_shared_from_this<Connector>{
+public:
+    using NewConnectionCallback = std::function<void(int sockfd)>;
+    using ConnectFailedCallback = std::function<void()>;
+
+    Connector(EventLoop* loop, const InetAddress& serverAddr);
+    ~Connector();
+
+    void setNewConnectionCallback(const NewConnectionCallback& cb){
+        newConnectionCallback_ = cb;
+    }
+
+    //重试maxRetries次都失败后回调，-1（默认）表示一直重试
+    void setMaxRetries(int maxRetries){
+        maxRetries_ = maxRetries;
+    }
+    void setConnectFailedCallback(const ConnectFailedCallback& cb){
+        connectFailedCallback_ = cb;
+    }
+
+    const InetAddress& serverAddress() const{
+        return serverAddr_;
+    }
+
+    //任意线程调用
+    void start();
+    //连接断开后重新连接，退避时间重置。只在loop线程调用
+    void restart();
+    //停止连接和重试，任意线程调用；在loop线程调用时返回后不会再有回调
+    void stop();
+
+private:
+    enum States {kDisconnected, kConnecting, kConnected};
+    static const int kMaxRetryDelayMs = 30 * 1000;
+    static const int kInitRetryDelayMs = 500;
+
+    void setState(States s){
+        state_ = s;
+    }
+    void startInLoop();
+    void stopInLoop();
+    void connect();
+    void connecting(int sockfd);
+    void handleWrite();
+    void handleError();
+    void retry(int sockfd);
+    int removeAndResetChannel();
+    void resetChannel();
+
+    EventLoop* loop_;
+    InetAddress serverAddr_;
+    std::atomic_bool connect_;
+    States state_;
+    std::unique_ptr<Channel> channel_;
+    NewConnectionCallback newConnectionCallback_;
+    ConnectFailedCallback connectFailedCallback_;
+    int retryDelayMs_;
+    int maxRetries_;
+    int retries_;
+    TimerId retryTimer_;
+    bool retryScheduled_;
+};
+
+using ConnectorPtr = std::shared_ptr<Connector>;
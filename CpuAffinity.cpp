@@ -0,0 +1,87 @@
+#include "CpuAffinity.h"
+#include "Logger.h"
+
+#include <sched.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/**
+ * 线程绑核：sched_setaffinity(0, ...)只影响调用线程，所以要在loop线程里、创建EventLoop之前调用。
+ * NUMA：不依赖libnuma，cpu所属节点从/sys/devices/system/cpu/cpuN/nodeM读出，内存策略用set_mempolicy系统调用设置。
+ *       内存策略也只影响调用线程之后的分配（按首次访问分配物理页），所以在loop线程里先设置策略再创建EventLoop，
+ *       EventLoop、BufferPool以及之后在这个线程里分配的Buffer存储就都落在本节点上。
+*/
+
+namespace CpuAffinity{
+
+//<linux/mempolicy.h>里的值，这里直接写出来避免依赖内核头文件版本
+static const int kMpolPreferred = 1;
+
+bool bindThisThread(const std::vector<int>& cpus){
+    if(cpus.empty()){
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for(int cpu : cpus){
+        if(cpu < 0 || cpu >= CPU_SETSIZE){
+            LOG_ERROR("%s:%s:%d invalid cpu %d\n", __FILE__, __FUNCTION__, __LINE__, cpu);
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    if(::sched_setaffinity(0, sizeof(set), &set) < 0){
+        LOG_ERROR("%s:%s:%d sched_setaffinity err %d\n", __FILE__, __FUNCTION__, __LINE__, errno);
+        return false;
+    }
+    return true;
+}
+
+int nodeOfCpu(int cpu){
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dir = ::opendir(path);
+    if(dir == nullptr){
+        return -1;
+    }
+    int node = -1;
+    while(struct dirent* entry = ::readdir(dir)){
+        if(strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9'){
+            node = atoi(entry->d_name + 4);
+            break;
+        }
+    }
+    ::closedir(dir);
+    return node;
+}
+
+int commonNode(const std::vector<int>& cpus){
+    int node = -1;
+    for(size_t i = 0; i < cpus.size(); ++i){
+        int n = nodeOfCpu(cpus[i]);
+        if(n < 0 || (i > 0 && n != node)){
+            return -1;
+        }
+        node = n;
+    }
+    return node;
+}
+
+bool preferNode(int node){
+    if(node < 0 || node >= static_cast<int>(sizeof(unsigned long) * 8)){
+        return false;
+    }
+    unsigned long mask = 1UL << node;
+    if(::syscall(SYS_set_mempolicy, kMpolPreferred, &mask, sizeof(mask) * 8 + 1) < 0){
+        LOG_ERROR("%s:%s:%d set_mempolicy node %d err %d\n", __FILE__, __FUNCTION__, __LINE__, node, errno);
+        return false;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+//线程绑核和NUMA内存策略，只作用于调用线程
+namespace CpuAffinity{
+
+    //把调用线程绑定到cpus里的这些核上，失败返回false
+    bool bindThisThread(const std::vector<int>& cpus);
+
+    //cpu所在的NUMA节点，没有NUMA信息（单节点或读不到sysfs）时返回-1
+    int nodeOfCpu(int cpu);
+
+    //cpus都在同一个NUMA节点上时返回该节点，否则返回-1
+    int commonNode(const std::vector<int>& cpus);
+
+    //之后调用线程分配的内存优先放在node上（MPOL_PREFERRED，节点内存不够时仍可从别的节点分配），失败返回false
+    bool preferNode(int node);
+}
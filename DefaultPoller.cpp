@@ -1,11 +1,18 @@
 #include "Poller.h"
 #include "EPollPoller.h"
+#include "IoUringPoller.h"
+#include "Logger.h"
 #include <stdlib.h>
 
+//环境变量MUDUO_USE_IO_URING选择io_uring后端，内核不支持时退回epoll
 Poller* Poller::newDefaultPoller(EventLoop* loop){
-    if(::getenv("MUDUO_USE_POLL")){
-        return nullptr;
-    }else{
-        return new EPollPoller(loop);
+    if(::getenv("MUDUO_USE_IO_URING")){
+        IoUringPoller* poller = new IoUringPoller(loop);
+        if(poller->valid()){
+            return poller;
+        }
+        delete poller;
+        LOG_ERROR("io_uring unavailable, falling back to epoll");
     }
-}
\ No newline at end of file
+    return new EPollPoller(loop);
+}
@@ -5,6 +5,7 @@
 #include <sys/types.h>
 #include <sys/epoll.h>
 #include <unistd.h>
+#include <algorithm>
 
 namespace{
     const int kNew = -1;
@@ -13,10 +14,14 @@ namespace{
 }
 
 /**
- * 负责维护：map<sockfd, Channel*>类型的一个MapList，里面是它监控的所有channel。
+ * 负责维护：Poller::channels_，以fd为下标的vector<Channel*>，里面是它监控的所有channel，查找不需要哈希。
  *          eventsList_是一个<epoll_event>类型的vector，作为epoll_wait的返回参数，传出所有的活跃事件
  * 
- * map<sockfd, Channel*>的维护：可以增删改查自己维护的Channel列表。一般是由 channel update -> eventLoop update -> epoll update执行
+ * channels_的维护：一般是由 channel update -> eventLoop update -> epoll update执行
+ *          updateChannel只登记channel、改index，再markDirty(fd)把fd记进dirtyFds_，本身不调用epoll_ctl。
+ *          kernelStates_同样以fd为下标，记录内核里实际注册的事件。applyPendingUpdates在epoll_wait之前遍历dirtyFds_，
+ *          和channel当前的events()对比，有差别才ADD/MOD/DEL，同一轮里先enable再disable之类的来回切换不产生系统调用。
+ *          removeChannel之后fd马上会被关闭复用，所以不走延迟提交，立即从epoll删除。
  * eventsList_ 是vector<epoll_event>，相当于一个事件暂存的容器，每次epoll_wait的返回数据都存在这里。
  *              会有一个扩容机制：当返回事件个数达到自己的容量时，会resize * 2。
  * 
@@ -36,6 +41,7 @@ EPollPoller::~EPollPoller(){
 }
 
 TimeStamp EPollPoller::poll(int timeoutMs, ChannelList* activeChannels){
+    applyPendingUpdates();
     int numEvents = epoll_wait(epoll_fd_, &*eventsList_.begin(), static_cast<int>(eventsList_.size()), timeoutMs);
     int savedErrno = errno;
     TimeStamp now(TimeStamp::now());
@@ -65,33 +71,59 @@ void EPollPoller::fillActiveChannels(int numEvents, ChannelList* activeChannels)
 
 void EPollPoller::updateChannel(Channel* channel){
     const int index = channel->index();
-    LOG_INFO("function %s, fd %d, events %d, index %d", __FUNCTION__, channel->fd(), channel->events(), index);
+    LOG_DEBUG("function %s, fd %d, events %d, index %d", __FUNCTION__, channel->fd(), channel->events(), index);
+    int fd = channel->fd();
     if(index == kNew || index == kDeleted){
-        int fd = channel->fd();
         if(index == kNew){
-            channels_[fd] = channel;
+            addChannel(channel);
         }
-
         channel->set_index(kAdded);
-        update(EPOLL_CTL_ADD, channel);
-    }else{
-        int fd = channel->fd();
-        if(channel->isNoneEvent()){
+    }else if(channel->isNoneEvent()){
+        channel->set_index(kDeleted);
+    }
+    markDirty(fd);
+}
+
+void EPollPoller::markDirty(int fd){
+    if(static_cast<size_t>(fd) >= kernelStates_.size()){
+        kernelStates_.resize(std::max(static_cast<size_t>(fd) + 1, kernelStates_.size() * 2));
+    }
+    if(!kernelStates_[fd].dirty){
+        kernelStates_[fd].dirty = true;
+        dirtyFds_.push_back(fd);
+    }
+}
+
+void EPollPoller::applyPendingUpdates(){
+    for(int fd : dirtyFds_){
+        KernelState& state = kernelStates_[fd];
+        state.dirty = false;
+        Channel* channel = findChannel(fd);
+        int wanted = (channel != nullptr && !channel->isNoneEvent()) ? channel->events() : 0;
+        if(!state.added){
+            if(wanted != 0){
+                update(EPOLL_CTL_ADD, channel);
+                state.added = true;
+                state.events = wanted;
+            }
+        }else if(wanted == 0){
             update(EPOLL_CTL_DEL, channel);
-            channel->set_index(kDeleted);
-        }else{
+            state.added = false;
+        }else if(wanted != state.events){
             update(EPOLL_CTL_MOD, channel);
+            state.events = wanted;
         }
     }
+    dirtyFds_.clear();
 }
-    
+
 void EPollPoller::removeChannel(Channel* channel){
     int fd = channel->fd();
-    int index = channel->index();
-    size_t sz = channels_.erase(fd);
+    eraseChannel(fd);
 
-    if(index == kAdded){
+    if(static_cast<size_t>(fd) < kernelStates_.size() && kernelStates_[fd].added){
         update(EPOLL_CTL_DEL, channel);
+        kernelStates_[fd].added = false;
     }
     channel->set_index(kNew);
 }
@@ -105,6 +137,7 @@ void EPollPoller::update(int operation, Channel* channel){
     epevt.data.ptr = channel;
     int fd = channel->fd();
 
+    countCtl();
     if(::epoll_ctl(epoll_fd_, operation, fd, &epevt) < 0){
         if(operation == EPOLL_CTL_DEL){
             LOG_ERROR("epoll_ctl op %d", operation);
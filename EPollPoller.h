@@ -19,6 +19,10 @@ private:
     
     void fillActiveChannels(int numEvents, ChannelList* activeChannels) const;
 
+    //把本轮积累的关注事件变化在epoll_wait之前统一提交，和内核里已注册的一致就不调用epoll_ctl
+    void applyPendingUpdates();
+    void markDirty(int fd);
+
     void update(int operation, Channel* channel);
 
     using EventList = std::vector<epoll_event>;
@@ -26,4 +30,14 @@ private:
 
     int epoll_fd_;
     EventList eventsList_;
+
+    //以fd为下标，记录内核里实际注册的状态
+    struct KernelState{
+        KernelState() : events(0), added(false), dirty(false){}
+        int events;
+        bool added;
+        bool dirty;
+    };
+    std::vector<KernelState> kernelStates_;
+    std::vector<int> dirtyFds_;
 };
\ No newline at end of file
@@ -3,18 +3,30 @@
 #include "CurrentThread.h"
 #include "Logger.h"
 #include "Channel.h"
+#include "TimerQueue.h"
+#include "TimingWheel.h"
+#include "BufferPool.h"
 
 #include <sys/eventfd.h>
+#include <time.h>
 
 /**
- * 维护了一个pendingFunctors，是vector保存的一堆待执行函数。由mutex负责保护
+ * 维护了一个pendingFunctors，是无锁的多生产者单消费者队列保存的一堆其它线程投递的待执行函数，本线程投递的放在localFunctors_。
+ *          任务类型是只能移动的Task，常见的连接闭包放得进它的内部缓冲，投递不分配内存。
+ *          wakeupPending_保证一轮循环里只有第一次跨线程投递会写eventfd，之后的投递只入队
  * 维护了一个vector<channel*>activeChannels_，和poller里的eventsList_一样，临时存储活跃的channel。由poller负责写入
  * 维护了一个wakeupFd_和wakeupChannel，并在这个wakeupChannel上设置了handleRead函数，就是读取8个字节无意义数据，用于唤醒epoll
  * 维护了一个poller，不用解释
+ * 维护了一个timerQueue_，由timerfd驱动的定时器队列，runAt/runAfter/runEvery/cancel都转发给它。
+ *          epoll_wait的超时时间取kPollTimeMs和最近一个定时器到期时间的较小值
+ * 维护了一个timingWheel_，懒创建，给海量连接的空闲超时/写超时用，靠timerQueue_的runEvery驱动
+ * 维护了一个bufferPool_，本loop上所有连接的Buffer从这里取存储、读空后还回来。构造时就创建，因为TcpConnection在baseLoop里构造时就要拿到它
  * 维护了std::atomic_bool looping_ 和 quit_变量，用于给loop循环看，是否循环，是循环还是退出
  * 
  * loop函数：先epoll_wait，找到活跃的channel，执行上面的回调函数；
  *          然后查看pendingFactors上是否有任务，有的话就全部执行掉。
+ *          开了忙轮询时，最近一次有活跃事件之后的busyPollUs_微秒内epoll_wait超时为0，省掉线程阻塞再被唤醒的延迟，
+ *          空闲超过这段时间就回到阻塞等待，不会一直空转占满一个核。
  * 
  * quit函数：修改状态为quit_，然后检查是否是在本线程内。如果是在本线程内，说明这个quit函数肯定是在本线程的loop函数内执行的（muduo的所有函数都是在loop内执行的），
  *          那么肯定能运行到下一轮while，检查quit_标志，就可以退出了。
@@ -30,6 +42,12 @@ __thread EventLoop* t_loopInThisThread = nullptr;
 
 const int kPollTimeMs = 10000;
 
+static int64_t monotonicMicroSeconds(){
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
 int creatEventFd(){
     int evtFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
     if(evtFd < 0)
@@ -39,9 +57,17 @@ int creatEventFd(){
 
 EventLoop::EventLoop() : looping_(false), quit_(false), threadId_(CurrentThread::tid()),
     poller_(Poller::newDefaultPoller(this)),
+    timerQueue_(new TimerQueue(this)),
+    bufferPool_(new BufferPool(this)),
+    overflowBuffer_(new char[kOverflowBufferSize]),
     wakeupFd_(creatEventFd()),
     wakeupChannel_(new Channel(this, wakeupFd_)),
-    callPendingFunctors_(false){
+    callPendingFunctors_(false),
+    wakeupPending_(false),
+    busyPollUs_(0),
+    socketBusyPollUs_(0),
+    connectionLoad_(0),
+    pendingBytes_(0){
     
     LOG_DEBUG("EventLoop create : %p in thread %d \n", this, threadId_);
 
@@ -76,11 +102,29 @@ void EventLoop::loop(){
 
     LOG_INFO("eventLoop %p start looping\n", this);
 
+    //忙轮询截止时间，单调时钟微秒
+    int64_t spinUntil = 0;
+
     while(!quit_){
 
         activeChannels_.clear();
-        
-        pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+
+        int timeoutMs = timerQueue_->nextTimeoutMs(kPollTimeMs);
+        //上一轮flush阶段本线程又投递了任务或flush（没有写eventfd），这一轮poll不能阻塞
+        if(!localFunctors_.empty() || !flushFunctors_.empty()){
+            timeoutMs = 0;
+        }
+        if(busyPollUs_ > 0 && spinUntil > 0){
+            if(monotonicMicroSeconds() < spinUntil){
+                timeoutMs = 0;
+            }else{
+                spinUntil = 0;
+            }
+        }
+        pollReturnTime_ = poller_->poll(timeoutMs, &activeChannels_);
+        if(busyPollUs_ > 0 && !activeChannels_.empty()){
+            spinUntil = monotonicMicroSeconds() + busyPollUs_;
+        }
         
         //处理用户业务事件 + 可能的读8字节wakefd
         for(auto channel : activeChannels_){
@@ -89,6 +133,9 @@ void EventLoop::loop(){
 
         //处理非用户事件
         doPendingFunctors();
+
+        //本轮攒下的输出统一写出
+        doFlushFunctors();
     }
 }
 
@@ -103,20 +150,29 @@ void EventLoop::runInLoop(Functor cb){
     if(isInLoopThread()){
         cb();
     }else{
-        queueInLoop(cb);
+        queueInLoop(std::move(cb));
     }
 }
 
+void EventLoop::queueFlush(Functor cb){
+    flushFunctors_.emplace_back(std::move(cb));
+}
+
 void EventLoop::queueInLoop(Functor cb){
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        pendingFunctors_.emplace_back(cb);
+    //本线程投递的不需要经过无锁队列，放进只有本线程访问的vector，不用为每个任务分配队列节点
+    if(isInLoopThread()){
+        localFunctors_.push_back(std::move(cb));
+    }else{
+        pendingFunctors_.push(std::move(cb));
     }
     //1. 其它线程持有本loop，并且插入了任务函数，则需要唤醒本线程
     //2. 本线程在执行pendingFunctors的时候，某些任务又需要插入新任务，则需要再次唤醒一下epoll。这样，在执行完缓存的本队列后，
     //    epoll又会触发并再次装填待执行任务
+    //wakeupPending_已经是true说明eventfd已经写过、loop还没开始取任务，这次入队的任务一定会被取到
     if(!isInLoopThread() || callPendingFunctors_){
-        wakeup();
+        if(!wakeupPending_.exchange(true, std::memory_order_acq_rel)){
+            wakeup();
+        }
     }
 }
 
@@ -128,10 +184,39 @@ void EventLoop::wakeup(){
     }
 }
 
+TimerId EventLoop::runAt(TimeStamp time, TimerCallback cb){
+    return timerQueue_->addTimer(std::move(cb), time, 0.0);
+}
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb){
+    TimeStamp time(addTime(TimeStamp::now(), delay));
+    return runAt(time, std::move(cb));
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb){
+    TimeStamp time(addTime(TimeStamp::now(), interval));
+    return timerQueue_->addTimer(std::move(cb), time, interval);
+}
+
+void EventLoop::cancel(TimerId timerId){
+    timerQueue_->cancel(timerId);
+}
+
+TimingWheel* EventLoop::timingWheel(){
+    if(!timingWheel_){
+        timingWheel_.reset(new TimingWheel(this));
+    }
+    return timingWheel_.get();
+}
+
 void EventLoop::updateChannel(Channel* channel){
     poller_->updateChannel(channel);
 }
 
+uint64_t EventLoop::pollerCtlCalls() const{
+    return poller_->ctlCalls();
+}
+
 void EventLoop::removeChannel(Channel* channel){
     poller_->removeChannel(channel);
 }
@@ -141,16 +226,31 @@ bool EventLoop::hasChannel(Channel* channel){
 }
 
 void EventLoop::doPendingFunctors(){
-    std::vector<Functor> functors;
     callPendingFunctors_ = true;
-    {
-        std::unique_lock<std::mutex> lock(mutex_);
-        functors.swap(pendingFunctors_);
+    //先清掉标记再取任务：之后入队的生产者会重新写eventfd，下一轮再取
+    wakeupPending_.exchange(false, std::memory_order_acq_rel);
+    //runningFunctors_上一轮清空后保留了容量，和localFunctors_交换后两边都不用重新分配
+    runningFunctors_.swap(localFunctors_);
+    Functor functor;
+    while(pendingFunctors_.pop(&functor)){
+        runningFunctors_.push_back(std::move(functor));
     }
 
-    for(auto f : functors){
+    for(Functor& f : runningFunctors_){
         f();
     }
+    runningFunctors_.clear();
 
     callPendingFunctors_ = false;
 }
+
+void EventLoop::doFlushFunctors(){
+    if(flushFunctors_.empty()){
+        return;
+    }
+    runningFunctors_.swap(flushFunctors_);
+    for(Functor& f : runningFunctors_){
+        f();
+    }
+    runningFunctors_.clear();
+}
@@ -3,17 +3,24 @@
 #include <vector>
 #include <atomic>
 #include <memory>
-#include <mutex>
 #include "noncopyable.h"
 #include "TimeStamp.h"
 #include "CurrentThread.h"
+#include "Callbacks.h"
+#include "TimerId.h"
+#include "MpscQueue.h"
+#include "Task.h"
 
 class Channel;
 class Poller;
+class TimerQueue;
+class TimingWheel;
+class BufferPool;
 
 class EventLoop : noncopyable{
 public:
-    using Functor = std::function<void()>;
+    //只能移动的任务类型，捕获一个TcpConnectionPtr加几个参数的闭包投递时不分配内存
+    using Functor = Task;
 
     EventLoop();
     ~EventLoop();
@@ -30,6 +37,56 @@ public:
 
     void wakeup();
 
+    //本轮循环的活跃事件和pendingFunctors_都处理完之后执行，用于auto-cork的连接统一刷出。只能在本loop线程调用
+    void queueFlush(Functor cb);
+
+    //定时器，线程安全，可以在任意线程调用
+    TimerId runAt(TimeStamp time, TimerCallback cb);
+    TimerId runAfter(double delay, TimerCallback cb);
+    TimerId runEvery(double interval, TimerCallback cb);
+    void cancel(TimerId timerId);
+
+    //连接空闲/写超时用的时间轮，第一次使用时创建，只能在本loop线程调用
+    TimingWheel* timingWheel();
+
+    //本loop上连接的Buffer存储池，只能在本loop线程使用（统计值除外）
+    BufferPool* bufferPool(){
+        return bufferPool_.get();
+    }
+
+    //本loop上所有连接readFd共用的溢出缓冲，只在本loop线程使用，用完即弃，不需要清零
+    static const size_t kOverflowBufferSize = 64 * 1024;
+    char* overflowBuffer(){
+        return overflowBuffer_.get();
+    }
+
+    //忙轮询：有事件之后的spinUs微秒内以0超时poll，期间一直空闲才恢复阻塞等待；spinUs为0（默认）时总是阻塞。
+    //socketBusyPollUs大于0时本loop上的连接socket设置SO_BUSY_POLL。只能在本loop线程或loop开始之前调用
+    void setBusyPoll(int spinUs, int socketBusyPollUs = 0){
+        busyPollUs_ = spinUs;
+        socketBusyPollUs_ = socketBusyPollUs;
+    }
+    int socketBusyPollUs() const{
+        return socketBusyPollUs_;
+    }
+
+    //poller累计的epoll_ctl（或io_uring poll增删）次数，任意线程可读，两次采样相减除以间隔即每秒调用数
+    uint64_t pollerCtlCalls() const;
+
+    //本loop的负载：连接数、连接待发送的字节数。由TcpConnection维护，EventLoopThreadPool据此选择loop，任意线程可读写
+    void addConnectionLoad(int delta){
+        connectionLoad_.fetch_add(delta, std::memory_order_relaxed);
+    }
+    int connectionLoad() const{
+        return connectionLoad_.load(std::memory_order_relaxed);
+    }
+    void addPendingBytes(int64_t delta){
+        pendingBytes_.fetch_add(delta, std::memory_order_relaxed);
+    }
+    int64_t pendingBytes() const{
+        return pendingBytes_.load(std::memory_order_relaxed);
+    }
+
     void updateChannel(Channel*);
     void removeChannel(Channel*);
     bool hasChannel(Channel*);
@@ -41,6 +98,7 @@ public:
 private:
     void handleRead();
     void doPendingFunctors();
+    void doFlushFunctors();
 
     using ChannelList = std::vector<Channel*>;
     std::atomic_bool looping_;
@@ -50,6 +108,10 @@ private:
 
     TimeStamp pollReturnTime_;
     std::unique_ptr<Poller> poller_;
+    std::unique_ptr<TimerQueue> timerQueue_;
+    std::unique_ptr<TimingWheel> timingWheel_;
+    std::unique_ptr<BufferPool> bufferPool_;
+    std::unique_ptr<char[]> overflowBuffer_;
 
     int wakeupFd_;
     std::unique_ptr<Channel> wakeupChannel_;
@@ -57,7 +119,18 @@ private:
     ChannelList activeChannels_;
 
     std::atomic_bool callPendingFunctors_;
-    std::vector<Functor> pendingFunctors_;
-    std::mutex mutex_;  //mutex 用于保护 vector<Functor> pendingFunctors_
+    MpscQueue<Functor> pendingFunctors_;  //无锁队列，任意线程push，只有本loop线程取
+    //已经写过wakeupFd_、本loop还没开始取任务，期间其他投递不必再写eventfd
+    std::atomic_bool wakeupPending_;
+
+    std::vector<Functor> localFunctors_;  //本loop线程自己投递的任务
+    std::vector<Functor> flushFunctors_;
+    std::vector<Functor> runningFunctors_;  //正在执行的一批任务，复用容量
+
+    int busyPollUs_;
+    int socketBusyPollUs_;
+
+    std::atomic<int> connectionLoad_;
+    std::atomic<int64_t> pendingBytes_;
 
 };
\ No newline at end of file
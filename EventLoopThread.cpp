@@ -1,5 +1,7 @@
 #include "EventLoopThread.h"
 #include "EventLoop.h"
+#include "CpuAffinity.h"
+#include "Logger.h"
 #include <functional>
 
 /**
@@ -9,11 +11,14 @@
  *            新线程则一直调用loop循环。直到退出loop后，使用互斥量将loop_设置为nullptr
  *与Thread类的区别：Thread类是通用的，可以执行任何线程函数。
   EventLoopThread类的功能：创建loop、利用Thread线程类执行Loop类的loop函数
+ *
+ * 设置了cpus_时，新线程先绑核、设置NUMA内存策略，再创建loop，这样loop自己的分配（poller、BufferPool等）也在本节点上
 */
 
 EventLoopThread::EventLoopThread(const ThreadInitCallBack& cb , const std::string &name)
     : loop_(nullptr), exiting_(false), 
-    thread_(std::bind(&EventLoopThread::threadFunc, this), name), mutex_(), cond_(), callback_(cb){
+    thread_(std::bind(&EventLoopThread::threadFunc, this), name), mutex_(), cond_(), callback_(cb), bindNuma_(false),
+    busyPollUs_(0), socketBusyPollUs_(0){
 
 }
 
@@ -41,7 +46,14 @@ EventLoop* EventLoopThread::startLoop(){
 
 
 void EventLoopThread::threadFunc(){
+    if(!cpus_.empty() && CpuAffinity::bindThisThread(cpus_) && bindNuma_){
+        int node = CpuAffinity::commonNode(cpus_);
+        if(node >= 0){
+            CpuAffinity::preferNode(node);
+        }
+    }
     EventLoop loop;
+    loop.setBusyPoll(busyPollUs_, socketBusyPollUs_);
     if(callback_){
         callback_(&loop);
     }
@@ -3,6 +3,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <string>
+#include <vector>
 #include "noncopyable.h"
 #include "Thread.h"
 
@@ -15,6 +16,18 @@ public:
     EventLoopThread(const ThreadInitCallBack& cb = ThreadInitCallBack(), const std::string &name = std::string());
     ~EventLoopThread();
 
+    //loop线程绑定到cpus上，bindNuma时这些核同属一个NUMA节点的话，loop线程的内存也优先从该节点分配。必须在startLoop之前设置
+    void setCpuAffinity(const std::vector<int>& cpus, bool bindNuma){
+        cpus_ = cpus;
+        bindNuma_ = bindNuma;
+    }
+
+    //见EventLoop::setBusyPoll，loop创建后、开始循环前设置。必须在startLoop之前调用
+    void setBusyPoll(int spinUs, int socketBusyPollUs){
+        busyPollUs_ = spinUs;
+        socketBusyPollUs_ = socketBusyPollUs;
+    }
+
     EventLoop* startLoop();
 
 private:
@@ -26,4 +39,8 @@ private:
     std::mutex mutex_;
     std::condition_variable cond_;
     ThreadInitCallBack callback_;
+    std::vector<int> cpus_;
+    bool bindNuma_;
+    int busyPollUs_;
+    int socketBusyPollUs_;
 };
\ No newline at end of file
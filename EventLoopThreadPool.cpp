@@ -1,6 +1,10 @@
 #include "EventLoopThreadPool.h"
 #include "EventLoopThread.h"
-
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include <algorithm>
+#include <stdio.h>
+#include <time.h>
 
 
 /**
@@ -12,11 +16,27 @@
  *          需要同步，因为创建loop并设置，是在新线程完成的，而EventLoopThread的start函数需要保证返回时，loop已经设置好，因此使用条件变量来进行
  *          新线程和原线程的线程同步。
  * 
+ *          设置了cpuSets_时，每个EventLoopThread在自己的线程里先绑核再创建loop。
  * getNextLoop：利用next_变量返回下一个loop即可。
+ * getNextLoop(peerAddr)：按policy_选择loop。各loop的连接数和待发字节数由TcpConnection在各自线程里原子地更新，
+ *          这里读到的只是近似值，足够用来做分配。最少连接/最少待发字节扫描全部loop，从next_开始扫以便平手时轮流分配；
+ *          两次随机选择只看两个loop，loop很多时开销不随loop数增长；一致性哈希在start时建好哈希环，按对端ip查找。
 */
 
+//把32位整数打散，用于ip和虚拟节点的哈希
+static uint32_t mix32(uint32_t h){
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
 EventLoopThreadPool::EventLoopThreadPool(EventLoop* baseLoop, const std::string& nameArg)
-    : baseLoop_(baseLoop), name_(nameArg), started_(false), numThreads_(0), next_(0){
+    : baseLoop_(baseLoop), name_(nameArg), started_(false), numThreads_(0), next_(0),
+      policy_(kRoundRobin), randState_(static_cast<uint32_t>(::time(nullptr)) | 1), bindNuma_(true),
+      busyPollUs_(0), socketBusyPollUs_(0){
 
 }
 
@@ -28,11 +48,24 @@ void EventLoopThreadPool::start(const ThreadInitCallback& cb){
         char buf[name_.size() + 32];
         snprintf(buf, sizeof(buf), "%s %d", name_.c_str(), i);
         EventLoopThread *t = new EventLoopThread(cb, buf);
+        if(!cpuSets_.empty()){
+            t->setCpuAffinity(cpuSets_[i % cpuSets_.size()], bindNuma_);
+        }
+        t->setBusyPoll(busyPollUs_, socketBusyPollUs_);
         threads_.push_back(std::unique_ptr<EventLoopThread>(t));
         loops_.push_back(t->startLoop());
     }
-    if(numThreads_ == 0 && cb){
-        cb(baseLoop_);
+    if(numThreads_ == 0){
+        //start在baseLoop线程、loop开始之前调用
+        if(busyPollUs_ > 0 || socketBusyPollUs_ > 0){
+            baseLoop_->setBusyPoll(busyPollUs_, socketBusyPollUs_);
+        }
+        if(cb){
+            cb(baseLoop_);
+        }
+    }
+    if(policy_ == kConsistentHash){
+        buildHashRing();
     }
 }
 
@@ -48,6 +81,90 @@ EventLoop* EventLoopThreadPool::getNextLoop(){
     return loop;
 }
 
+EventLoop* EventLoopThreadPool::getNextLoop(const InetAddress& peerAddr){
+    if(loops_.size() <= 1){
+        return getNextLoop();
+    }
+    switch(policy_){
+    case kLeastConnections:
+        return leastLoaded(false);
+    case kLeastPendingBytes:
+        return leastLoaded(true);
+    case kPowerOfTwoChoices:
+        return powerOfTwoChoices();
+    case kConsistentHash:
+        return consistentHash(peerAddr);
+    default:
+        return getNextLoop();
+    }
+}
+
+EventLoop* EventLoopThreadPool::leastLoaded(bool byPendingBytes){
+    int n = static_cast<int>(loops_.size());
+    int best = next_;
+    for(int k = 1; k < n; ++k){
+        int i = (next_ + k) % n;
+        EventLoop* a = loops_[i];
+        EventLoop* b = loops_[best];
+        bool better;
+        if(byPendingBytes && a->pendingBytes() != b->pendingBytes()){
+            better = a->pendingBytes() < b->pendingBytes();
+        }else{
+            better = a->connectionLoad() < b->connectionLoad();
+        }
+        if(better){
+            best = i;
+        }
+    }
+    //下次从选中的下一个开始扫，负载相同的loop才会真正轮流分到连接
+    next_ = (best + 1) % n;
+    return loops_[best];
+}
+
+EventLoop* EventLoopThreadPool::powerOfTwoChoices(){
+    uint32_t n = static_cast<uint32_t>(loops_.size());
+    uint32_t i = nextRandom() % n;
+    //第二个从其余n-1个里选，保证两个不同
+    uint32_t j = (i + 1 + nextRandom() % (n - 1)) % n;
+    EventLoop* a = loops_[i];
+    EventLoop* b = loops_[j];
+    if(a->connectionLoad() != b->connectionLoad()){
+        return a->connectionLoad() < b->connectionLoad() ? a : b;
+    }
+    return a->pendingBytes() <= b->pendingBytes() ? a : b;
+}
+
+EventLoop* EventLoopThreadPool::consistentHash(const InetAddress& peerAddr){
+    uint32_t h = mix32(peerAddr.getSockaddr()->sin_addr.s_addr);
+    auto it = std::lower_bound(ring_.begin(), ring_.end(), std::make_pair(h, 0));
+    if(it == ring_.end()){
+        it = ring_.begin();
+    }
+    return loops_[it->second];
+}
+
+void EventLoopThreadPool::buildHashRing(){
+    ring_.clear();
+    ring_.reserve(loops_.size() * kVirtualNodes);
+    for(size_t i = 0; i < loops_.size(); ++i){
+        for(int v = 0; v < kVirtualNodes; ++v){
+            uint32_t h = mix32(static_cast<uint32_t>(i) * 0x9e3779b9u + mix32(static_cast<uint32_t>(v) + 1));
+            ring_.push_back(std::make_pair(h, static_cast<int>(i)));
+        }
+    }
+    std::sort(ring_.begin(), ring_.end());
+}
+
+//xorshift32，只在baseLoop线程调用
+uint32_t EventLoopThreadPool::nextRandom(){
+    uint32_t x = randState_;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    randState_ = x;
+    return x;
+}
+
 std::vector<EventLoop*> EventLoopThreadPool::getAllLoops(){
     if(loops_.empty()){
         return std::vector<EventLoop*>(1, baseLoop_);
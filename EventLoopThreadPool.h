@@ -5,22 +5,51 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <utility>
+#include <stdint.h>
 
 class EventLoop;
 class EventLoopThread;
+class InetAddress;
 
 class EventLoopThreadPool : noncopyable{
 public:
     using ThreadInitCallback = std::function<void(EventLoop*)>;
+
+    //新连接分给哪个subLoop
+    enum LoadBalance{
+        kRoundRobin,            //轮询
+        kLeastConnections,      //连接数最少
+        kLeastPendingBytes,     //待发送字节最少，连接数作次要依据
+        kPowerOfTwoChoices,     //随机取两个，选连接数少的
+        kConsistentHash,        //按对端ip一致性哈希，同一ip总落在同一个loop
+    };
     
     EventLoopThreadPool(EventLoop* baseLoop, const std::string& nameArg);
     ~EventLoopThreadPool();
 
     void setThreadNum(int numThreads){ numThreads_ = numThreads; }
 
+    //必须在start之前设置
+    void setLoadBalance(LoadBalance policy){ policy_ = policy; }
+
+    //第i个loop线程绑定到cpuSets[i % cpuSets.size()]，bindNuma见EventLoopThread::setCpuAffinity。必须在start之前设置
+    void setCpuAffinity(const std::vector<std::vector<int>>& cpuSets, bool bindNuma = true){
+        cpuSets_ = cpuSets;
+        bindNuma_ = bindNuma;
+    }
+
     void start(const ThreadInitCallback& cb = ThreadInitCallback());
 
+    //所有subLoop的轮询策略，见EventLoop::setBusyPoll。必须在start之前设置；没有subLoop时作用于baseLoop
+    void setBusyPoll(int spinUs, int socketBusyPollUs = 0){
+        busyPollUs_ = spinUs;
+        socketBusyPollUs_ = socketBusyPollUs;
+    }
+
     EventLoop* getNextLoop();
+    //按负载均衡策略为来自peerAddr的新连接选择loop，只在baseLoop线程调用
+    EventLoop* getNextLoop(const InetAddress& peerAddr);
 
     std::vector<EventLoop*> getAllLoops();
 
@@ -29,11 +58,27 @@ public:
     const std::string name() const { return name_ ;}
     
 private:
+    static const int kVirtualNodes = 64;
+
+    EventLoop* leastLoaded(bool byPendingBytes);
+    EventLoop* powerOfTwoChoices();
+    EventLoop* consistentHash(const InetAddress& peerAddr);
+    void buildHashRing();
+    uint32_t nextRandom();
+
     EventLoop *baseLoop_;
     std::string name_;
     bool started_;
     int numThreads_;
     int next_;
+    LoadBalance policy_;
+    uint32_t randState_;
+    //(哈希值, loop下标)，按哈希值排序，每个loop有kVirtualNodes个虚拟节点
+    std::vector<std::pair<uint32_t, int>> ring_;
+    std::vector<std::vector<int>> cpuSets_;
+    bool bindNuma_;
+    int busyPollUs_;
+    int socketBusyPollUs_;
     std::vector<std::unique_ptr<EventLoopThread>> threads_;
     std::vector<EventLoop*> loops_;
 };
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "FileCache.h"
+#include "Logger.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+ * FileCache：维护了 path -> CachedFile 的map和一条LRU链表，由mutex保护
+ * open：先stat检查文件是否变化，命中且没变化就直接返回缓存的CachedFilePtr，省掉open/fstat/close；
+ *       没命中或已变化就重新open，超过maxFiles_时淘汰最久没用的
+ *       被淘汰的CachedFile如果还有连接在发送，由shared_ptr保证发完才close
+*/
+
+CachedFile::~CachedFile(){
+    ::close(fd_);
+}
+
+FileCache::FileCache(size_t maxFiles) : maxFiles_(maxFiles){
+
+}
+
+CachedFilePtr FileCache::open(const std::string& path){
+    struct stat st;
+    if(::stat(path.c_str(), &st) < 0 || !S_ISREG(st.st_mode)){
+        return CachedFilePtr();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = files_.find(path);
+        if(it != files_.end()){
+            const CachedFilePtr& file = it->second.file;
+            if(file->mtime() == st.st_mtime && file->size() == static_cast<size_t>(st.st_size)){
+                lru_.splice(lru_.begin(), lru_, it->second.lruPos);
+                return file;
+            }
+            lru_.erase(it->second.lruPos);
+            files_.erase(it);
+        }
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        LOG_ERROR("FileCache::open %s failed, errno: %d", path.c_str(), errno);
+        return CachedFilePtr();
+    }
+    if(::fstat(fd, &st) < 0){
+        ::close(fd);
+        return CachedFilePtr();
+    }
+    CachedFilePtr file = std::make_shared<CachedFile>(fd, st.st_size, st.st_mtime);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = files_.find(path);
+    if(it != files_.end()){
+        //别的线程同时打开了同一个文件
+        lru_.erase(it->second.lruPos);
+        files_.erase(it);
+    }
+    lru_.push_front(path);
+    Entry entry;
+    entry.file = file;
+    entry.lruPos = lru_.begin();
+    files_[path] = entry;
+    while(files_.size() > maxFiles_){
+        files_.erase(lru_.back());
+        lru_.pop_back();
+    }
+    return file;
+}
+
+void FileCache::invalidate(const std::string& path){
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = files_.find(path);
+    if(it != files_.end()){
+        lru_.erase(it->second.lruPos);
+        files_.erase(it);
+    }
+}
+
+size_t FileCache::size() const{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return files_.size();
+}
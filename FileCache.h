@@ -0,0 +1,67 @@
+#pragma once
+
+#include "noncopyable.h"
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <sys/types.h>
+#include <time.h>
+
+/**
+ * 一个打开的只读文件，析构时close。TcpConnection::sendFile持有它直到文件发完
+*/
+class CachedFile : noncopyable{
+public:
+    CachedFile(int fd, size_t size, time_t mtime) : fd_(fd), size_(size), mtime_(mtime){}
+    ~CachedFile();
+
+    int fd() const{
+        return fd_;
+    }
+
+    size_t size() const{
+        return size_;
+    }
+
+    time_t mtime() const{
+        return mtime_;
+    }
+
+private:
+    const int fd_;
+    const size_t size_;
+    const time_t mtime_;
+};
+
+using CachedFilePtr = std::shared_ptr<CachedFile>;
+
+/**
+ * 热点文件的fd缓存，所有loop共享，线程安全。按LRU淘汰，文件被修改（mtime或大小变化）后重新打开
+*/
+class FileCache : noncopyable{
+public:
+    explicit FileCache(size_t maxFiles = 1024);
+
+    //打开失败返回nullptr
+    CachedFilePtr open(const std::string& path);
+
+    void invalidate(const std::string& path);
+
+    size_t size() const;
+
+private:
+    using LruList = std::list<std::string>;
+    struct Entry{
+        CachedFilePtr file;
+        LruList::iterator lruPos;
+    };
+
+    const size_t maxFiles_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> files_;
+    //最近使用的在前面
+    LruList lru_;
+};
@@ -0,0 +1,363 @@
+#include "HttpContext.h"
+#include "Buffer.h"
+
+#include <string.h>
+#include <stdlib.h>
+
+/**
+ * HttpContext：增量解析的状态机，状态和各字段的偏移都在本对象里，inputBuffer里的数据要等整个请求处理完才被取走
+ * 请求行、头部：按行解析，pos_指向下一行开头，上次没凑够一行的部分下次从pos_接着找，不从头扫描
+ *          头部收齐后根据Transfer-Encoding/Content-Length决定请求体的读法，两者都没有就是没有请求体，两者都有按400拒绝
+ * Content-Length请求体：直接等数据到齐，body是inputBuffer里的视图
+ * chunked请求体：块大小行、块数据交替，块数据拼进chunkedBody_（只有这种情况拷贝），最后一个0块之后跳过trailer直到空行。
+ *          块大小行、trailer都有长度上限；块数据在inputBuffer里的原件和拷贝一起计入请求体上限，内存占用不会翻倍超限
+ * 出错：记下应答的状态码，返回kError，由HttpServer回复错误并关闭连接
+*/
+
+const size_t HttpContext::kMaxHeaderBytes;
+const size_t HttpContext::kMaxBodyBytes;
+
+HttpContext::HttpContext()
+    : state_(kExpectRequestLine), pos_(0), version_(HttpRequest::kUnknown),
+    chunked_(false), contentLength_(0), bodyOffset_(0), chunkRemaining_(0), trailerOffset_(0), errorStatus_(0){
+}
+
+bool HttpContext::nextLine(const char* base, size_t readable, size_t* lineLen, size_t* next) const{
+    const char* begin = base + pos_;
+    const char* lf = static_cast<const char*>(memchr(begin, '\n', readable - pos_));
+    if(lf == nullptr){
+        return false;
+    }
+    size_t len = lf - begin;
+    if(len > 0 && begin[len - 1] == '\r'){
+        --len;
+    }
+    *lineLen = len;
+    *next = lf - base + 1;
+    return true;
+}
+
+bool HttpContext::fail(int status){
+    errorStatus_ = status;
+    return false;
+}
+
+HttpContext::ParseResult HttpContext::parse(Buffer* buf, TimeStamp receiveTime){
+    const char* base = buf->peek();
+    const size_t readable = buf->readableBytes();
+    size_t lineLen = 0;
+    size_t next = 0;
+
+    while(state_ != kGotAll){
+        switch(state_){
+        case kExpectRequestLine:
+        case kExpectHeaders:
+            if(!nextLine(base, readable, &lineLen, &next)){
+                if(readable > kMaxHeaderBytes){
+                    fail(431);
+                    return kError;
+                }
+                return kNeedMore;
+            }
+            if(next > kMaxHeaderBytes){
+                fail(431);
+                return kError;
+            }
+            if(state_ == kExpectRequestLine){
+                //请求之间多余的空行忽略
+                if(lineLen > 0 && !parseRequestLine(base, lineLen)){
+                    return kError;
+                }
+                if(lineLen > 0){
+                    state_ = kExpectHeaders;
+                }
+                pos_ = next;
+            }else if(lineLen == 0){
+                pos_ = next;
+                if(!headersComplete(base)){
+                    return kError;
+                }
+            }else{
+                if(!parseHeaderLine(base, lineLen)){
+                    return kError;
+                }
+                pos_ = next;
+            }
+            break;
+
+        case kExpectBody:
+            if(readable - bodyOffset_ < contentLength_){
+                return kNeedMore;
+            }
+            pos_ = bodyOffset_ + contentLength_;
+            state_ = kGotAll;
+            break;
+
+        case kExpectChunkSize:{
+            if(!nextLine(base, readable, &lineLen, &next)){
+                if(readable - pos_ > kMaxHeaderBytes){
+                    fail(400);
+                    return kError;
+                }
+                return kNeedMore;
+            }
+            if(lineLen > kMaxHeaderBytes){
+                fail(400);
+                return kError;
+            }
+            const char* line = base + pos_;
+            char* end = nullptr;
+            unsigned long long size = strtoull(line, &end, 16);
+            //块大小后面只允许跟块扩展（;...）
+            if(end == line || (end < line + lineLen && *end != ';' && *end != ' ' && *end != '\t')){
+                fail(400);
+                return kError;
+            }
+            //这一块的数据会在inputBuffer（pos_之前的都还没取走）和chunkedBody_里各有一份
+            if(size > kMaxBodyBytes || pos_ + chunkedBody_.size() + 2 * size > kMaxBodyBytes){
+                fail(413);
+                return kError;
+            }
+            pos_ = next;
+            chunkRemaining_ = static_cast<size_t>(size);
+            state_ = (size == 0) ? kExpectTrailers : kExpectChunkData;
+            trailerOffset_ = pos_;
+            break;
+        }
+
+        case kExpectChunkData:{
+            //块数据后面紧跟\r\n
+            if(readable - pos_ < chunkRemaining_ + 2){
+                return kNeedMore;
+            }
+            const char* data = base + pos_;
+            if(data[chunkRemaining_] != '\r' || data[chunkRemaining_ + 1] != '\n'){
+                fail(400);
+                return kError;
+            }
+            chunkedBody_.append(data, chunkRemaining_);
+            pos_ += chunkRemaining_ + 2;
+            chunkRemaining_ = 0;
+            state_ = kExpectChunkSize;
+            break;
+        }
+
+        case kExpectTrailers:
+            if(!nextLine(base, readable, &lineLen, &next)){
+                if(readable - trailerOffset_ > kMaxHeaderBytes){
+                    fail(431);
+                    return kError;
+                }
+                return kNeedMore;
+            }
+            if(next - trailerOffset_ > kMaxHeaderBytes){
+                fail(431);
+                return kError;
+            }
+            pos_ = next;
+            if(lineLen == 0){
+                state_ = kGotAll;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    buildRequest(base, receiveTime);
+    return kComplete;
+}
+
+bool HttpContext::parseRequestLine(const char* base, size_t len){
+    const char* begin = base + pos_;
+    const char* end = begin + len;
+    const char* space = static_cast<const char*>(memchr(begin, ' ', len));
+    if(space == nullptr || space == begin){
+        return fail(400);
+    }
+    method_.offset = pos_;
+    method_.len = space - begin;
+
+    const char* target = space + 1;
+    space = static_cast<const char*>(memchr(target, ' ', end - target));
+    if(space == nullptr || space == target){
+        return fail(400);
+    }
+    target_.offset = target - base;
+    target_.len = space - target;
+
+    const char* version = space + 1;
+    if(end - version != 8 || memcmp(version, "HTTP/1.", 7) != 0){
+        return fail(505);
+    }
+    if(version[7] == '1'){
+        version_ = HttpRequest::kHttp11;
+    }else if(version[7] == '0'){
+        version_ = HttpRequest::kHttp10;
+    }else{
+        return fail(505);
+    }
+    return true;
+}
+
+bool HttpContext::parseHeaderLine(const char* base, size_t len){
+    const char* begin = base + pos_;
+    const char* end = begin + len;
+    const char* colon = static_cast<const char*>(memchr(begin, ':', len));
+    if(colon == nullptr || colon == begin){
+        return fail(400);
+    }
+    const char* value = colon + 1;
+    while(value < end && (*value == ' ' || *value == '\t')){
+        ++value;
+    }
+    const char* valueEnd = end;
+    while(valueEnd > value && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t')){
+        --valueEnd;
+    }
+    HeaderRange header;
+    header.name.offset = pos_;
+    header.name.len = colon - begin;
+    header.value.offset = value - base;
+    header.value.len = valueEnd - value;
+    headers_.push_back(header);
+    return true;
+}
+
+StringPiece HttpContext::lastToken(StringPiece list){
+    const char* begin = list.data();
+    const char* end = begin + list.size();
+    const char* p = end;
+    while(p > begin && p[-1] != ','){
+        --p;
+    }
+    while(p < end && (*p == ' ' || *p == '\t')){
+        ++p;
+    }
+    while(end > p && (end[-1] == ' ' || end[-1] == '\t')){
+        --end;
+    }
+    return StringPiece(p, end - p);
+}
+
+bool HttpContext::headersComplete(const char* base){
+    bool hasLength = false;
+    for(const HeaderRange& header : headers_){
+        StringPiece name(base + header.name.offset, header.name.len);
+        StringPiece value(base + header.value.offset, header.value.len);
+        if(name.equalsIgnoreCase("Transfer-Encoding")){
+            //只支持chunked作为最后一种编码：取最后一个逗号之后的编码名整体比较，xchunked之类的不算
+            if(lastToken(value).equalsIgnoreCase("chunked")){
+                chunked_ = true;
+            }else{
+                return fail(501);
+            }
+        }else if(name.equalsIgnoreCase("Content-Length")){
+            if(value.empty()){
+                return fail(400);
+            }
+            size_t len = 0;
+            for(size_t i = 0; i < value.size(); ++i){
+                if(value[i] < '0' || value[i] > '9'){
+                    return fail(400);
+                }
+                len = len * 10 + (value[i] - '0');
+                if(len > kMaxBodyBytes){
+                    return fail(413);
+                }
+            }
+            if(hasLength && len != contentLength_){
+                return fail(400);
+            }
+            contentLength_ = len;
+            hasLength = true;
+        }
+    }
+    //两个都有时前后端可能各认一个来切分请求（请求走私，RFC 7230 3.3.3），直接拒绝
+    if(chunked_ && hasLength){
+        return fail(400);
+    }
+    if(chunked_){
+        state_ = kExpectChunkSize;
+    }else if(contentLength_ > 0){
+        bodyOffset_ = pos_;
+        state_ = kExpectBody;
+    }else{
+        state_ = kGotAll;
+    }
+    return true;
+}
+
+void HttpContext::buildRequest(const char* base, TimeStamp receiveTime){
+    HttpRequest& req = request_;
+    req.methodString_ = StringPiece(base + method_.offset, method_.len);
+    struct MethodName{
+        const char* name;
+        HttpRequest::Method method;
+    };
+    static const MethodName kMethods[] = {
+        {"GET", HttpRequest::kGet}, {"POST", HttpRequest::kPost}, {"HEAD", HttpRequest::kHead},
+        {"PUT", HttpRequest::kPut}, {"DELETE", HttpRequest::kDelete}, {"OPTIONS", HttpRequest::kOptions},
+        {"PATCH", HttpRequest::kPatch},
+    };
+    req.method_ = HttpRequest::kInvalid;
+    for(const MethodName& m : kMethods){
+        if(req.methodString_ == m.name){
+            req.method_ = m.method;
+            break;
+        }
+    }
+
+    const char* target = base + target_.offset;
+    const char* question = static_cast<const char*>(memchr(target, '?', target_.len));
+    if(question != nullptr){
+        req.path_ = StringPiece(target, question - target);
+        req.query_ = StringPiece(question + 1, target + target_.len - question - 1);
+    }else{
+        req.path_ = StringPiece(target, target_.len);
+        req.query_ = StringPiece();
+    }
+    req.version_ = version_;
+
+    req.headers_.clear();
+    for(const HeaderRange& header : headers_){
+        req.headers_.push_back(HttpRequest::Header(StringPiece(base + header.name.offset, header.name.len),
+            StringPiece(base + header.value.offset, header.value.len)));
+    }
+
+    if(chunked_){
+        req.body_ = StringPiece(chunkedBody_);
+    }else{
+        req.body_ = StringPiece(base + bodyOffset_, contentLength_);
+    }
+    req.receiveTime_ = receiveTime;
+
+    StringPiece connection = req.getHeader("Connection");
+    if(version_ == HttpRequest::kHttp11){
+        req.keepAlive_ = !connection.equalsIgnoreCase("close");
+    }else{
+        req.keepAlive_ = connection.equalsIgnoreCase("keep-alive");
+    }
+}
+
+void HttpContext::finishRequest(Buffer* buf){
+    buf->retrieve(pos_);
+    reset();
+}
+
+void HttpContext::reset(){
+    state_ = kExpectRequestLine;
+    pos_ = 0;
+    method_ = Range();
+    target_ = Range();
+    version_ = HttpRequest::kUnknown;
+    headers_.clear();
+    chunked_ = false;
+    contentLength_ = 0;
+    bodyOffset_ = 0;
+    chunkRemaining_ = 0;
+    trailerOffset_ = 0;
+    chunkedBody_.clear();
+    errorStatus_ = 0;
+}
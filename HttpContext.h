@@ -0,0 +1,100 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "HttpRequest.h"
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+class Buffer;
+
+/**
+ * 每个HTTP连接一个，挂在TcpConnection的context上，保存增量解析的状态。
+ * 解析过程中只记录各字段相对inputBuffer可读区开头的偏移（数据没读完时Buffer可能搬动存储），
+ * 整个请求到齐后才换算成指向inputBuffer的视图交给HttpRequest
+*/
+class HttpContext : noncopyable{
+public:
+    enum ParseResult{
+        kNeedMore,
+        kComplete,
+        kError,
+    };
+
+    //请求行加头部的上限，超过返回431。chunked的块大小行（超过返回400）和trailer总长（超过返回431）也用这个上限
+    static const size_t kMaxHeaderBytes = 64 * 1024;
+    //请求体上限，超过返回413。chunked请求体在inputBuffer和拼接出的副本里各占一份，两份合计不超过它
+    static const size_t kMaxBodyBytes = 64 * 1024 * 1024;
+
+    HttpContext();
+
+    //从buf可读区开头继续解析当前请求，不取走数据。上次返回kNeedMore时已经解析过的部分不会重复解析
+    ParseResult parse(Buffer* buf, TimeStamp receiveTime);
+
+    //parse返回kComplete之后、finishRequest之前有效
+    const HttpRequest& request() const{
+        return request_;
+    }
+
+    //parse返回kError时应答的状态码
+    int errorStatus() const{
+        return errorStatus_;
+    }
+
+    //从buf取走已经处理完的请求，准备解析下一个（流水线请求可能已经在buf里了）
+    void finishRequest(Buffer* buf);
+
+    //丢弃当前请求的解析状态，不动buf。解析出错后清空buf的话必须调用，否则保存的偏移指向已经不存在的数据
+    void reset();
+
+private:
+    enum State{
+        kExpectRequestLine,
+        kExpectHeaders,
+        kExpectBody,
+        kExpectChunkSize,
+        kExpectChunkData,
+        kExpectTrailers,
+        kGotAll,
+    };
+
+    //相对可读区开头的一段
+    struct Range{
+        Range() : offset(0), len(0){}
+        size_t offset;
+        size_t len;
+    };
+    struct HeaderRange{
+        Range name;
+        Range value;
+    };
+
+    //从pos_开始找一行，返回false表示还没有完整的一行。*lineLen不含行尾的\r\n
+    bool nextLine(const char* base, size_t readable, size_t* lineLen, size_t* next) const;
+    bool parseRequestLine(const char* base, size_t len);
+    bool parseHeaderLine(const char* base, size_t len);
+    //逗号分隔列表里的最后一项，去掉两边空白
+    static StringPiece lastToken(StringPiece list);
+    //头部收齐，根据Content-Length/Transfer-Encoding决定怎么读请求体
+    bool headersComplete(const char* base);
+    bool fail(int status);
+    void buildRequest(const char* base, TimeStamp receiveTime);
+
+    State state_;
+    //下一个要解析的字节相对可读区开头的偏移
+    size_t pos_;
+    Range method_;
+    Range target_;
+    HttpRequest::Version version_;
+    std::vector<HeaderRange> headers_;
+    bool chunked_;
+    size_t contentLength_;
+    size_t bodyOffset_;
+    size_t chunkRemaining_;
+    //trailer开始的偏移，用来限制trailer总长
+    size_t trailerOffset_;
+    //chunked请求体需要拼接，只有这种情况拷贝
+    std::string chunkedBody_;
+    int errorStatus_;
+    HttpRequest request_;
+};
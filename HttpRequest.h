@@ -0,0 +1,78 @@
+#pragma once
+
+#include "StringPiece.h"
+#include "TimeStamp.h"
+#include <vector>
+#include <utility>
+
+/**
+ * 一个解析完成的HTTP请求。method、path、头部等都是指向连接inputBuffer的视图，不拷贝；
+ * 只在HttpServer的请求回调期间有效，回调返回后这段数据就被取走了，需要保留的部分自己toString
+*/
+class HttpRequest{
+public:
+    enum Method{
+        kInvalid, kGet, kPost, kHead, kPut, kDelete, kOptions, kPatch
+    };
+    enum Version{
+        kUnknown, kHttp10, kHttp11
+    };
+
+    using Header = std::pair<StringPiece, StringPiece>;
+
+    HttpRequest() : method_(kInvalid), version_(kUnknown), keepAlive_(false){}
+
+    Method method() const{
+        return method_;
+    }
+    StringPiece methodString() const{
+        return methodString_;
+    }
+    //请求目标中?之前的部分
+    StringPiece path() const{
+        return path_;
+    }
+    //?之后的部分，不含?
+    StringPiece query() const{
+        return query_;
+    }
+    Version version() const{
+        return version_;
+    }
+    const std::vector<Header>& headers() const{
+        return headers_;
+    }
+    //头名不区分大小写，没有时返回空
+    StringPiece getHeader(const StringPiece& name) const{
+        for(const Header& header : headers_){
+            if(header.first.equalsIgnoreCase(name)){
+                return header.second;
+            }
+        }
+        return StringPiece();
+    }
+    //chunked请求体是拼好的副本，其他情况是inputBuffer里的视图
+    StringPiece body() const{
+        return body_;
+    }
+    TimeStamp receiveTime() const{
+        return receiveTime_;
+    }
+    //按版本和Connection头算出的，响应之后是否保持连接
+    bool keepAlive() const{
+        return keepAlive_;
+    }
+
+private:
+    friend class HttpContext;
+
+    Method method_;
+    StringPiece methodString_;
+    StringPiece path_;
+    StringPiece query_;
+    Version version_;
+    std::vector<Header> headers_;
+    StringPiece body_;
+    TimeStamp receiveTime_;
+    bool keepAlive_;
+};
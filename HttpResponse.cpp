@@ -0,0 +1,70 @@
+#include "HttpResponse.h"
+#include "Buffer.h"
+
+#include <stdio.h>
+
+/**
+ * 头部在addHeader时就拼成最终格式存进headers_，appendToBuffer只做几次append：状态行、Content-Length、Connection、headers_、空行、body
+*/
+
+void HttpResponse::addHeader(const StringPiece& name, const StringPiece& value){
+    headers_.append(name.data(), name.size());
+    headers_.append(": ", 2);
+    headers_.append(value.data(), value.size());
+    headers_.append("\r\n", 2);
+}
+
+void HttpResponse::appendToBuffer(Buffer* out, bool headOnly, HttpRequest::Version version) const{
+    char buf[128];
+    int n = snprintf(buf, sizeof buf, "HTTP/1.1 %d ", statusCode_);
+    out->append(buf, n);
+    if(statusMessage_.empty()){
+        StringPiece reason(reasonPhrase(statusCode_));
+        out->append(reason.data(), reason.size());
+    }else{
+        out->append(statusMessage_.data(), statusMessage_.size());
+    }
+    n = snprintf(buf, sizeof buf, "\r\nContent-Length: %zu\r\n", body_.size());
+    out->append(buf, n);
+    if(closeConnection_){
+        static const char kClose[] = "Connection: close\r\n";
+        out->append(kClose, sizeof(kClose) - 1);
+    }else if(version == HttpRequest::kHttp10){
+        static const char kKeepAlive[] = "Connection: keep-alive\r\n";
+        out->append(kKeepAlive, sizeof(kKeepAlive) - 1);
+    }
+    out->append(headers_.data(), headers_.size());
+    out->append("\r\n", 2);
+    if(!headOnly){
+        out->append(body_.data(), body_.size());
+    }
+}
+
+const char* HttpResponse::reasonPhrase(int code){
+    switch(code){
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 414: return "URI Too Long";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 505: return "HTTP Version Not Supported";
+    default: return "Unknown";
+    }
+}
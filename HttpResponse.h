@@ -0,0 +1,64 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "StringPiece.h"
+#include "HttpRequest.h"
+#include <string>
+
+class Buffer;
+
+/**
+ * HTTP响应的构造器：请求回调里设置状态、头部和body，回调返回后由HttpServer用appendToBuffer直接写进要发送的Buffer
+*/
+class HttpResponse : noncopyable{
+public:
+    explicit HttpResponse(bool close) : statusCode_(200), closeConnection_(close){}
+
+    void setStatusCode(int code){
+        statusCode_ = code;
+    }
+    int statusCode() const{
+        return statusCode_;
+    }
+    //不设置时按状态码取标准的原因短语
+    void setStatusMessage(const std::string& message){
+        statusMessage_ = message;
+    }
+
+    void setCloseConnection(bool on){
+        closeConnection_ = on;
+    }
+    bool closeConnection() const{
+        return closeConnection_;
+    }
+
+    void setContentType(const StringPiece& contentType){
+        addHeader("Content-Type", contentType);
+    }
+    //直接拼成"name: value\r\n"，Content-Length和Connection由appendToBuffer写，不要自己加
+    void addHeader(const StringPiece& name, const StringPiece& value);
+
+    void setBody(const StringPiece& body){
+        body_.assign(body.data(), body.size());
+    }
+    void setBody(std::string&& body){
+        body_.swap(body);
+    }
+    void appendBody(const StringPiece& data){
+        body_.append(data.data(), data.size());
+    }
+
+    //headOnly：HEAD请求只写头部，Content-Length仍是body的长度。
+    //version是请求的版本：HTTP/1.0默认不保持连接，保持时要显式回Connection: keep-alive
+    void appendToBuffer(Buffer* out, bool headOnly = false, HttpRequest::Version version = HttpRequest::kHttp11) const;
+
+    //常见状态码的原因短语，未知的返回"Unknown"
+    static const char* reasonPhrase(int code);
+
+private:
+    int statusCode_;
+    std::string statusMessage_;
+    bool closeConnection_;
+    std::string headers_;
+    std::string body_;
+};
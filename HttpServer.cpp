@@ -0,0 +1,78 @@
+#include "HttpServer.h"
+#include "HttpContext.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "TcpConnection.h"
+#include "Logger.h"
+
+/**
+ * HttpServer：维护了一个TcpServer，每个连接建立时挂一个HttpContext
+ * onMessage：一次可读事件里可能到了多个流水线请求，循环解析，每解析完一个就同步调用httpCallback_，
+ *          响应按请求的顺序写进同一个Buffer（所属loop的BufferPool），全部处理完一次send交出：
+ *          outputBuffer_为空时没写完的部分连同存储直接换进outputBuffer_，多个响应也只有一次writev。
+ *          请求数据在回调返回后才从inputBuffer取走，所以request里的视图在回调期间一直有效。
+ *          需要关闭连接（请求不要keep-alive、回调要求关闭、解析出错）时，写完这个响应就shutdown，后面的流水线请求丢弃，
+ *          同时摘掉context，之后到达的数据不再解析
+*/
+
+static void defaultHttpCallback(const HttpRequest&, HttpResponse* resp){
+    resp->setStatusCode(404);
+    resp->setCloseConnection(true);
+}
+
+HttpServer::HttpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& name, TcpServer::Option option)
+    : loop_(loop), name_(name), server_(loop, listenAddr, name, option), httpCallback_(defaultHttpCallback){
+    server_.setConnectionCallback(std::bind(&HttpServer::onConnection, this, std::placeholders::_1));
+    server_.setMessageCallback(std::bind(&HttpServer::onMessage, this,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+}
+
+void HttpServer::start(){
+    LOG_INFO("HttpServer[%s] starts listening\n", name_.c_str());
+    server_.start();
+}
+
+void HttpServer::onConnection(const TcpConnectionPtr& conn){
+    if(conn->connected()){
+        conn->setContext(std::make_shared<HttpContext>());
+    }
+}
+
+void HttpServer::onMessage(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime){
+    HttpContext* context = static_cast<HttpContext*>(conn->getContext().get());
+    //已经决定关闭的连接：shutdown只关了写端，对端之后发来的数据直接丢弃
+    if(context == nullptr){
+        buf->retrieveAll();
+        return;
+    }
+    Buffer out(conn->getLoop()->bufferPool());
+    bool close = false;
+    while(!close){
+        HttpContext::ParseResult result = context->parse(buf, receiveTime);
+        if(result == HttpContext::kNeedMore){
+            break;
+        }
+        if(result == HttpContext::kError){
+            HttpResponse response(true);
+            response.setStatusCode(context->errorStatus());
+            response.appendToBuffer(&out);
+            close = true;
+            break;
+        }
+        const HttpRequest& request = context->request();
+        HttpResponse response(!request.keepAlive());
+        httpCallback_(request, &response);
+        response.appendToBuffer(&out, request.method() == HttpRequest::kHead, request.version());
+        close = response.closeConnection();
+        context->finishRequest(buf);
+    }
+    if(out.readableBytes() > 0){
+        conn->send(&out);
+    }
+    if(close){
+        //解析状态里的偏移随buf一起作废，直接摘掉context，后续数据在开头就被丢弃
+        buf->retrieveAll();
+        conn->setContext(std::shared_ptr<void>());
+        conn->shutdown();
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "TcpServer.h"
+#include <functional>
+#include <string>
+
+class HttpRequest;
+class HttpResponse;
+
+/**
+ * 基于TcpServer的HTTP/1.1服务器：支持keep-alive、流水线请求（按顺序应答）、chunked请求体。
+ * 请求回调在连接所属的loop线程里同步调用，request里的视图只在回调期间有效
+*/
+class HttpServer : noncopyable{
+public:
+    using HttpCallback = std::function<void(const HttpRequest&, HttpResponse*)>;
+
+    HttpServer(EventLoop* loop, const InetAddress& listenAddr, const std::string& name,
+        TcpServer::Option option = TcpServer::kNonReusePort);
+
+    EventLoop* getLoop() const{
+        return loop_;
+    }
+
+    //线程数、超时、accept方式等直接在底层TcpServer上设置，必须在start之前
+    TcpServer& tcpServer(){
+        return server_;
+    }
+
+    void setHttpCallback(const HttpCallback& cb){
+        httpCallback_ = cb;
+    }
+
+    void setThreadNum(int numThreads){
+        server_.setThreadNum(numThreads);
+    }
+
+    void start();
+
+private:
+    void onConnection(const TcpConnectionPtr& conn);
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime);
+
+    EventLoop* loop_;
+    const std::string name_;
+    TcpServer server_;
+    HttpCallback httpCallback_;
+};
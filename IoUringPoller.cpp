@@ -0,0 +1,385 @@
+#include "IoUringPoller.h"
+#include "Logger.h"
+#include "Channel.h"
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#include <algorithm>
+
+namespace{
+    const int kNew = -1;
+    const int kAdded = 1;
+    const int kDeleted = 2;
+
+    //POLL_REMOVE自身的完成事件用这个user_data，不对应任何channel
+    const uint64_t kIgnoreUserData = 0;
+    //探测multishot用的poll请求，fd部分是-1，findState找不到，它之后到达的cqe自然被丢弃
+    const uint64_t kProbeUserData = ~static_cast<uint64_t>(0);
+
+    //EPOLLET/EPOLLONESHOT等是epoll专有的控制位，不能作为poll掩码交给内核
+    const uint32_t kControlBits = EPOLLET | EPOLLONESHOT | EPOLLEXCLUSIVE | EPOLLWAKEUP;
+
+    int sysIoUringSetup(unsigned entries, struct io_uring_params* p){
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, p));
+    }
+
+    int sysIoUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t argsz){
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argsz));
+    }
+
+    uint64_t makeUserData(int fd, uint32_t generation){
+        return (static_cast<uint64_t>(static_cast<uint32_t>(fd)) << 32) | generation;
+    }
+}
+
+/**
+ * 负责维护：和EPollPoller一样以fd为下标的Channel表，以及每个fd挂在io_uring上的poll请求状态states_。
+ *
+ * 每个关注事件的channel对应一个IORING_OP_POLL_ADD请求，完成事件(cqe)的res就是发生的事件掩码：
+ *      普通channel用一次性poll，触发后在下一次poll前重新挂上，重挂时内核会立即检查一次就绪状态，所以和epoll默认的水平触发语义一致；
+ *      关注EPOLLET的channel用multishot poll，挂一次持续触发，直到被撤销。
+ * 修改/删除关注事件时提交POLL_REMOVE撤销旧请求并作废它的generation，旧请求之后到达的cqe按generation丢弃。
+ *
+ * 所有请求只写入SQ不立即提交，下一次poll时和等待事件一起通过一次io_uring_enter提交，
+ * 一轮循环里的增删改和等待只需要一次系统调用。等待超时通过IORING_ENTER_EXT_ARG传入，要求内核5.11以上。
+ * 边沿触发的channel固定关注读+写，只能靠multishot poll（内核5.13以上）实现，不能用一次性poll重挂模拟（fd一直可写会空转），
+ * 所以建ring时先用eventfd试挂一个multishot poll，不支持就视为io_uring不可用，由调用方退回epoll。
+*/
+IoUringPoller::IoUringPoller(EventLoop* loop):
+    Poller(loop),
+    ringFd_(-1),
+    toSubmit_(0),
+    nextGeneration_(0),
+    sqRing_(MAP_FAILED),
+    sqRingSize_(0),
+    cqRing_(MAP_FAILED),
+    cqRingSize_(0),
+    sqes_(static_cast<io_uring_sqe*>(MAP_FAILED)),
+    sqesSize_(0){
+
+    if(!setupRing()){
+        LOG_ERROR("IoUringPoller::IoUringPoller io_uring unavailable, errno=%d", errno);
+    }
+}
+
+IoUringPoller::~IoUringPoller(){
+    if(sqes_ != MAP_FAILED){
+        ::munmap(sqes_, sqesSize_);
+    }
+    if(cqRing_ != MAP_FAILED && cqRing_ != sqRing_){
+        ::munmap(cqRing_, cqRingSize_);
+    }
+    if(sqRing_ != MAP_FAILED){
+        ::munmap(sqRing_, sqRingSize_);
+    }
+    if(ringFd_ >= 0){
+        ::close(ringFd_);
+    }
+}
+
+bool IoUringPoller::setupRing(){
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+    int fd = sysIoUringSetup(kRingEntries, &params);
+    if(fd < 0){
+        return false;
+    }
+    if(!(params.features & IORING_FEAT_EXT_ARG)){
+        ::close(fd);
+        errno = ENOSYS;
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if(singleMmap){
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if(sqRing_ == MAP_FAILED){
+        ::close(fd);
+        return false;
+    }
+    if(singleMmap){
+        cqRing_ = sqRing_;
+    }else{
+        cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if(cqRing_ == MAP_FAILED){
+            ::close(fd);
+            return false;
+        }
+    }
+    sqesSize_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if(sqes == MAP_FAILED){
+        ::close(fd);
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqEntries_ = params.sq_entries;
+
+    char* cq = static_cast<char*>(cqRing_);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    ringFd_ = fd;
+    if(!probeMultishot()){
+        LOG_ERROR("IoUringPoller::setupRing multishot poll unsupported");
+        ::close(fd);
+        ringFd_ = -1;
+        errno = ENOSYS;
+        return false;
+    }
+    return true;
+}
+
+bool IoUringPoller::probeMultishot(){
+    //初值为1，eventfd一挂上就是可读的
+    int efd = ::eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+    if(efd < 0){
+        return false;
+    }
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = efd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = kProbeUserData;
+
+    //旧内核不认识IORING_POLL_ADD_MULTI，cqe的res是-EINVAL；支持的话res是POLLIN并且带IORING_CQE_F_MORE
+    bool supported = false;
+    if(sysIoUringEnter(ringFd_, toSubmit_, 1, IORING_ENTER_GETEVENTS, nullptr, 0) >= 0){
+        unsigned head = *cqHead_;
+        unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        for(; head != tail; ++head){
+            const io_uring_cqe* cqe = &cqes_[head & cqMask_];
+            if(cqe->user_data == kProbeUserData){
+                supported = cqe->res > 0 && (cqe->flags & IORING_CQE_F_MORE);
+            }
+        }
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+    }
+    toSubmit_ = 0;
+
+    if(supported){
+        //撤销探测请求，随第一次poll提交，它的cqe按user_data丢弃
+        sqe = getSqe();
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = kProbeUserData;
+        sqe->user_data = kIgnoreUserData;
+    }
+    ::close(efd);
+    return supported;
+}
+
+io_uring_sqe* IoUringPoller::getSqe(){
+    unsigned head = __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+    unsigned tail = *sqTail_;
+    if(tail - head >= sqEntries_){
+        //SQ满了，先把攒下的请求提交掉
+        if(sysIoUringEnter(ringFd_, toSubmit_, 0, 0, nullptr, 0) < 0){
+            LOG_ERROR("IoUringPoller::getSqe submit errno=%d", errno);
+        }
+        toSubmit_ = 0;
+    }
+    unsigned index = tail & sqMask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof *sqe);
+    sqArray_[index] = index;
+    __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+    ++toSubmit_;
+    return sqe;
+}
+
+TimeStamp IoUringPoller::poll(int timeoutMs, ChannelList* activeChannels){
+    rearmFired();
+
+    //上一轮已经有未取走的完成事件就不阻塞，只提交
+    unsigned minComplete = 1;
+    if(__atomic_load_n(cqTail_, __ATOMIC_ACQUIRE) != *cqHead_){
+        minComplete = 0;
+    }
+
+    struct __kernel_timespec ts;
+    struct io_uring_getevents_arg arg;
+    memset(&arg, 0, sizeof arg);
+    if(timeoutMs >= 0){
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000 * 1000;
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+
+    int ret = sysIoUringEnter(ringFd_, toSubmit_, minComplete,
+                              IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof arg);
+    int savedErrno = errno;
+    TimeStamp now(TimeStamp::now());
+    if(ret >= 0){
+        toSubmit_ -= std::min(static_cast<unsigned>(ret), toSubmit_);
+    }else if(savedErrno != EINTR && savedErrno != ETIME && savedErrno != EBUSY){
+        LOG_ERROR("IoUringPoller::poll() errno=%d", savedErrno);
+    }
+
+    fillActiveChannels(activeChannels);
+    return now;
+}
+
+void IoUringPoller::fillActiveChannels(ChannelList* activeChannels){
+    size_t first = activeChannels->size();
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    for(; head != tail; ++head){
+        const io_uring_cqe* cqe = &cqes_[head & cqMask_];
+        if(cqe->user_data == kIgnoreUserData){
+            continue;
+        }
+        int fd = static_cast<int>(cqe->user_data >> 32);
+        uint32_t generation = static_cast<uint32_t>(cqe->user_data);
+        PollState* found = findState(fd);
+        if(found == nullptr || found->generation != generation){
+            continue;
+        }
+        PollState& state = *found;
+        if(!state.multishot || !(cqe->flags & IORING_CQE_F_MORE)){
+            state.armed = false;
+            if(cqe->res >= 0){
+                fired_.push_back(fd);
+            }
+        }
+        if(cqe->res < 0){
+            if(cqe->res == -ECANCELED){
+                continue;
+            }
+            //挂poll失败，不会再有事件了：按错误+挂断报给channel，由使用者关闭，而不是让它悄无声息地失联
+            LOG_ERROR("IoUringPoller poll fd %d failed, res=%d", fd, cqe->res);
+            if(state.revents == 0){
+                activeChannels->push_back(findChannel(fd));
+            }
+            state.revents |= EPOLLERR | EPOLLHUP;
+            continue;
+        }
+        //同一个fd在一批cqe里可能出现多次，合并成一次事件
+        if(state.revents == 0){
+            activeChannels->push_back(findChannel(fd));
+        }
+        state.revents |= cqe->res;
+    }
+    __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+    for(size_t i = first; i < activeChannels->size(); ++i){
+        Channel* channel = (*activeChannels)[i];
+        PollState& state = states_[channel->fd()];
+        channel->set_revents(state.revents);
+        state.revents = 0;
+    }
+    if(activeChannels->size() > first){
+        LOG_DEBUG("%lu events happened.", activeChannels->size() - first);
+    }
+}
+
+void IoUringPoller::rearmFired(){
+    for(int fd : fired_){
+        PollState* state = findState(fd);
+        Channel* channel = findChannel(fd);
+        if(state == nullptr || state->armed || channel == nullptr){
+            continue;
+        }
+        if(channel->index() == kAdded && !channel->isNoneEvent()){
+            arm(channel, state);
+        }
+    }
+    fired_.clear();
+}
+
+void IoUringPoller::arm(Channel* channel, PollState* state){
+    if(++nextGeneration_ == 0){
+        nextGeneration_ = 1;
+    }
+    state->generation = nextGeneration_;
+    uint32_t events = static_cast<uint32_t>(channel->events());
+    countCtl();
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = channel->fd();
+    sqe->poll32_events = events & ~kControlBits;
+    state->multishot = (events & EPOLLET) != 0;
+    if(state->multishot){
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+    sqe->user_data = makeUserData(channel->fd(), state->generation);
+    state->armed = true;
+    state->events = channel->events();
+}
+
+void IoUringPoller::disarm(int fd, PollState* state){
+    countCtl();
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = makeUserData(fd, state->generation);
+    sqe->user_data = kIgnoreUserData;
+    state->armed = false;
+    //撤销之前已经产生但还没取走的cqe作废
+    state->generation = 0;
+}
+
+void IoUringPoller::updateChannel(Channel* channel){
+    const int index = channel->index();
+    const int fd = channel->fd();
+    LOG_DEBUG("function %s, fd %d, events %d, index %d", __FUNCTION__, fd, channel->events(), index);
+    if(index == kNew || index == kDeleted){
+        if(index == kNew){
+            addChannel(channel);
+            if(static_cast<size_t>(fd) >= states_.size()){
+                states_.resize(std::max(static_cast<size_t>(fd) + 1, states_.size() * 2));
+            }
+        }
+        channel->set_index(kAdded);
+        if(!channel->isNoneEvent()){
+            arm(channel, &states_[fd]);
+        }
+    }else{
+        PollState& state = states_[fd];
+        if(channel->isNoneEvent()){
+            if(state.armed){
+                disarm(fd, &state);
+            }
+            channel->set_index(kDeleted);
+        }else if(!state.armed || state.events != channel->events()){
+            if(state.armed){
+                disarm(fd, &state);
+            }
+            arm(channel, &state);
+        }
+    }
+}
+
+void IoUringPoller::removeChannel(Channel* channel){
+    int fd = channel->fd();
+    eraseChannel(fd);
+    PollState* state = findState(fd);
+    if(state != nullptr){
+        if(state->armed){
+            disarm(fd, state);
+        }
+        *state = PollState();
+    }
+    channel->set_index(kNew);
+}
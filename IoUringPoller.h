@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "Poller.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+//基于io_uring POLL_ADD的Poller，通过系统调用直接使用，不依赖liburing
+class IoUringPoller : public Poller{
+
+public:
+    IoUringPoller(EventLoop* loop);
+
+    ~IoUringPoller() override;
+
+    //内核不支持io_uring或multishot poll（或被seccomp禁用）时为false，调用方应换用EPollPoller
+    bool valid() const{
+        return ringFd_ >= 0;
+    }
+
+    TimeStamp poll(int timeoutMs, ChannelList* activeChannels) override;
+    void updateChannel(Channel* channel) override;
+    void removeChannel(Channel* channel) override;
+
+private:
+    static const unsigned kRingEntries = 256;
+
+    //每个fd当前挂在ring上的poll请求。generation写进user_data，不匹配的cqe是已撤销请求的残留，直接丢弃。
+    //generation全局递增，fd被关闭复用后也不会和旧请求混淆
+    struct PollState{
+        PollState() : generation(0), armed(false), multishot(false), events(0), revents(0){}
+        uint32_t generation;
+        bool armed;
+        bool multishot;
+        int events;
+        int revents;
+    };
+
+    bool setupRing();
+    //内核是否支持IORING_POLL_ADD_MULTI（5.13以上），边沿触发的channel依赖它
+    bool probeMultishot();
+    io_uring_sqe* getSqe();
+    PollState* findState(int fd){
+        return static_cast<size_t>(fd) < states_.size() ? &states_[fd] : nullptr;
+    }
+    void arm(Channel* channel, PollState* state);
+    void disarm(int fd, PollState* state);
+    void rearmFired();
+    void fillActiveChannels(ChannelList* activeChannels);
+
+    int ringFd_;
+    //请求批量放进SQ，下一次poll时和等待一起通过一次io_uring_enter提交
+    unsigned toSubmit_;
+    uint32_t nextGeneration_;
+
+    void* sqRing_;
+    size_t sqRingSize_;
+    void* cqRing_;
+    size_t cqRingSize_;
+    io_uring_sqe* sqes_;
+    size_t sqesSize_;
+
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned* sqArray_;
+    unsigned sqEntries_;
+
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+
+    //以fd为下标
+    std::vector<PollState> states_;
+    //一次性poll（水平触发语义）触发后需要重新挂上的fd，处理完本轮事件后在下一次poll前重挂
+    std::vector<int> fired_;
+};
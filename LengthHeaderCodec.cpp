@@ -0,0 +1,169 @@
+#include "LengthHeaderCodec.h"
+#include "Buffer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <endian.h>
+#include <string.h>
+
+/**
+ * onMessage：循环解析inputBuffer开头的长度头，够一整帧就回调frameCallback_(peek() + 头长度, 帧长度)，回调返回后retrieve这一帧；
+ *          不够一帧就留在Buffer里等下次。长度超过maxFrameSize_的帧不等它收完，解析出长度头就报错，避免对端用一个大长度把内存撑爆
+ * send：消息体已经在Buffer里时，长度头直接prepend到kCheapPrepend预留的空间（varint头超过8字节的情况，只有帧超过2^56字节才会出现）；
+ *          给的是裸指针时，在本loop线程用loop的BufferPool、跨线程用普通存储，拷贝一次进Buffer，再同样prepend头。
+ *          最后都用TcpConnection::send(Buffer*)交出，本loop线程时没写完的部分连存储一起换进outputBuffer_，跨线程时O(1)带进loop
+*/
+
+const size_t LengthHeaderCodec::kDefaultMaxFrameSize;
+const size_t LengthHeaderCodec::kMaxVarintBytes;
+
+LengthHeaderCodec::LengthHeaderCodec(const FrameCallback& cb, HeaderType type, size_t maxFrameSize)
+    : frameCallback_(cb), type_(type), maxFrameSize_(maxFrameSize){
+}
+
+void LengthHeaderCodec::onMessage(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime){
+    while(buf->readableBytes() > 0){
+        uint64_t len = 0;
+        size_t headerLen = 0;
+        int ret = decodeHeader(buf->peek(), buf->readableBytes(), &len, &headerLen);
+        if(ret == 0){
+            break;
+        }
+        if(ret < 0 || len > maxFrameSize_){
+            LOG_ERROR("LengthHeaderCodec [%s] invalid frame length %lu\n", conn->name().c_str(), (unsigned long)len);
+            handleError(conn, buf);
+            break;
+        }
+        if(buf->readableBytes() < headerLen + len){
+            break;
+        }
+        frameCallback_(conn, buf->peek() + headerLen, static_cast<size_t>(len), receiveTime);
+        buf->retrieve(headerLen + static_cast<size_t>(len));
+    }
+}
+
+void LengthHeaderCodec::handleError(const TcpConnectionPtr& conn, Buffer* buf){
+    buf->retrieveAll();
+    if(errorCallback_){
+        errorCallback_(conn);
+    }else{
+        conn->forceClose();
+    }
+}
+
+int LengthHeaderCodec::decodeHeader(const char* data, size_t readable, uint64_t* len, size_t* headerLen) const{
+    switch(type_){
+    case kInt8:
+        if(readable < 1){
+            return 0;
+        }
+        *len = static_cast<uint8_t>(data[0]);
+        *headerLen = 1;
+        return 1;
+    case kInt16:{
+        if(readable < 2){
+            return 0;
+        }
+        uint16_t be16 = 0;
+        memcpy(&be16, data, sizeof be16);
+        *len = be16toh(be16);
+        *headerLen = 2;
+        return 1;
+    }
+    case kInt32:{
+        if(readable < 4){
+            return 0;
+        }
+        uint32_t be32 = 0;
+        memcpy(&be32, data, sizeof be32);
+        *len = be32toh(be32);
+        *headerLen = 4;
+        return 1;
+    }
+    case kInt64:{
+        if(readable < 8){
+            return 0;
+        }
+        uint64_t be64 = 0;
+        memcpy(&be64, data, sizeof be64);
+        *len = be64toh(be64);
+        *headerLen = 8;
+        return 1;
+    }
+    default:{
+        uint64_t value = 0;
+        for(size_t i = 0; i < kMaxVarintBytes; ++i){
+            if(i >= readable){
+                return 0;
+            }
+            uint8_t byte = static_cast<uint8_t>(data[i]);
+            //第10个字节只能用到最低1位
+            if(i == kMaxVarintBytes - 1 && byte > 1){
+                return -1;
+            }
+            value |= static_cast<uint64_t>(byte & 0x7f) << (7 * i);
+            if((byte & 0x80) == 0){
+                *len = value;
+                *headerLen = i + 1;
+                return 1;
+            }
+        }
+        return -1;
+    }
+    }
+}
+
+size_t LengthHeaderCodec::encodeHeader(uint64_t len, char* out) const{
+    switch(type_){
+    case kInt8:
+        out[0] = static_cast<char>(len);
+        return 1;
+    case kInt16:{
+        uint16_t be16 = htobe16(static_cast<uint16_t>(len));
+        memcpy(out, &be16, sizeof be16);
+        return 2;
+    }
+    case kInt32:{
+        uint32_t be32 = htobe32(static_cast<uint32_t>(len));
+        memcpy(out, &be32, sizeof be32);
+        return 4;
+    }
+    case kInt64:{
+        uint64_t be64 = htobe64(len);
+        memcpy(out, &be64, sizeof be64);
+        return 8;
+    }
+    default:{
+        size_t n = 0;
+        while(len >= 0x80){
+            out[n++] = static_cast<char>((len & 0x7f) | 0x80);
+            len >>= 7;
+        }
+        out[n++] = static_cast<char>(len);
+        return n;
+    }
+    }
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, Buffer* buf){
+    size_t len = buf->readableBytes();
+    //定长头装不下的长度会被截断，对端按错误的长度分帧，宁可不发
+    uint64_t limit = (type_ == kVarint || type_ == kInt64) ? UINT64_MAX : ((1ULL << (8 * type_)) - 1);
+    if(len > maxFrameSize_ || len > limit){
+        LOG_ERROR("LengthHeaderCodec [%s] frame of %lu bytes exceeds limit\n", conn->name().c_str(), (unsigned long)len);
+        buf->retrieveAll();
+        return;
+    }
+    char header[kMaxVarintBytes];
+    size_t headerLen = encodeHeader(len, header);
+    buf->prepend(header, headerLen);
+    conn->send(buf);
+}
+
+void LengthHeaderCodec::send(const TcpConnectionPtr& conn, const void* data, size_t len){
+    EventLoop* loop = conn->getLoop();
+    Buffer buf(loop->isInLoopThread() ? loop->bufferPool() : nullptr);
+    buf.append(static_cast<const char*>(data), len);
+    send(conn, &buf);
+}
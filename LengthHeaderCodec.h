@@ -0,0 +1,67 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+
+class Buffer;
+class TimeStamp;
+
+/**
+ * 长度前缀分帧：每帧 = 网络字节序的长度头 + 消息体。长度头为固定1/2/4/8字节，或varint（每字节7位，低位在前，最高位表示后面还有）。
+ * 收：把onMessage设为连接的MessageCallback，每个完整的帧以指向inputBuffer里的(data, len)回调，不拷贝；
+ *     回调返回后才把这一帧从Buffer里取走，所以data只在回调期间有效。
+ * 发：消息体写进Buffer后，长度头写进它前面kCheapPrepend预留的空间，整个Buffer交给连接发送，消息体不会再被拷贝
+*/
+class LengthHeaderCodec : noncopyable{
+public:
+    enum HeaderType{
+        kVarint = 0,
+        kInt8 = 1,
+        kInt16 = 2,
+        kInt32 = 4,
+        kInt64 = 8,
+    };
+
+    using FrameCallback = std::function<void(const TcpConnectionPtr& conn, const char* data, size_t len, TimeStamp receiveTime)>;
+    //长度头非法或帧超过maxFrameSize，默认记日志并关闭连接
+    using ErrorCallback = std::function<void(const TcpConnectionPtr& conn)>;
+
+    static const size_t kDefaultMaxFrameSize = 64 * 1024 * 1024;
+    //varint长度头最长的字节数（64位长度）
+    static const size_t kMaxVarintBytes = 10;
+
+    explicit LengthHeaderCodec(const FrameCallback& cb, HeaderType type = kInt32, size_t maxFrameSize = kDefaultMaxFrameSize);
+
+    void setErrorCallback(const ErrorCallback& cb){
+        errorCallback_ = cb;
+    }
+
+    HeaderType headerType() const{
+        return type_;
+    }
+    size_t maxFrameSize() const{
+        return maxFrameSize_;
+    }
+
+    void onMessage(const TcpConnectionPtr& conn, Buffer* buf, TimeStamp receiveTime);
+
+    //buf里是一整个消息体，在它前面补上长度头后发送，buf被清空
+    void send(const TcpConnectionPtr& conn, Buffer* buf);
+    void send(const TcpConnectionPtr& conn, const void* data, size_t len);
+
+    //把len编码成长度头写到out，返回写了几个字节。out至少kMaxVarintBytes字节
+    size_t encodeHeader(uint64_t len, char* out) const;
+
+private:
+    //返回1表示解析出了完整的长度头，0表示数据还不够，-1表示长度头非法
+    int decodeHeader(const char* data, size_t readable, uint64_t* len, size_t* headerLen) const;
+    void handleError(const TcpConnectionPtr& conn, Buffer* buf);
+
+    FrameCallback frameCallback_;
+    ErrorCallback errorCallback_;
+    const HeaderType type_;
+    const size_t maxFrameSize_;
+};
@@ -0,0 +1,107 @@
+#include "LogFile.h"
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+/**
+ * LogFile：维护了一个FILE*，文件名为 basename.年月日-时分秒.主机名.pid.log
+ * append：fwrite_unlocked写入用户态缓冲（64KB），写满rollSize_字节就换一个新文件
+ *         每checkEveryN_次append看一下是否跨天，跨天也换新文件
+ * flush：由AsyncLogging每批写完后调用
+*/
+
+LogFile::LogFile(const std::string& basename, off_t rollSize, int checkEveryN)
+    : basename_(basename), rollSize_(rollSize), checkEveryN_(checkEveryN),
+    count_(0), writtenBytes_(0), startOfPeriod_(0), lastRoll_(0), fp_(nullptr){
+    rollFile();
+}
+
+LogFile::~LogFile(){
+    if(fp_ != nullptr){
+        ::fclose(fp_);
+    }
+}
+
+void LogFile::append(const char* logline, size_t len){
+    if(fp_ == nullptr){
+        return;
+    }
+    size_t written = 0;
+    while(written != len){
+        size_t n = ::fwrite_unlocked(logline + written, 1, len - written, fp_);
+        if(n == 0){
+            int err = ::ferror(fp_);
+            if(err){
+                fprintf(stderr, "LogFile::append() failed %s\n", strerror(err));
+            }
+            break;
+        }
+        written += n;
+    }
+    writtenBytes_ += written;
+
+    if(writtenBytes_ > rollSize_){
+        rollFile();
+    }else if(++count_ >= checkEveryN_){
+        count_ = 0;
+        time_t now = ::time(NULL);
+        time_t thisPeriod = now / kRollPerSeconds * kRollPerSeconds;
+        if(thisPeriod != startOfPeriod_){
+            rollFile();
+        }
+    }
+}
+
+void LogFile::flush(){
+    if(fp_ != nullptr){
+        ::fflush(fp_);
+    }
+}
+
+bool LogFile::rollFile(){
+    time_t now = 0;
+    std::string filename = getLogFileName(basename_, &now);
+    time_t start = now / kRollPerSeconds * kRollPerSeconds;
+
+    //一秒内不重复滚动，避免同名文件
+    if(now > lastRoll_){
+        lastRoll_ = now;
+        startOfPeriod_ = start;
+        writtenBytes_ = 0;
+        if(fp_ != nullptr){
+            ::fclose(fp_);
+        }
+        fp_ = ::fopen(filename.c_str(), "ae");
+        if(fp_ == nullptr){
+            fprintf(stderr, "LogFile::rollFile() open %s failed, errno: %d\n", filename.c_str(), errno);
+            return false;
+        }
+        ::setbuffer(fp_, buffer_, sizeof buffer_);
+        return true;
+    }
+    return false;
+}
+
+std::string LogFile::getLogFileName(const std::string& basename, time_t* now){
+    std::string filename(basename);
+
+    char timebuf[32];
+    struct tm tm;
+    *now = ::time(NULL);
+    ::localtime_r(now, &tm);
+    strftime(timebuf, sizeof timebuf, ".%Y%m%d-%H%M%S.", &tm);
+    filename += timebuf;
+
+    char hostname[256] = {0};
+    if(::gethostname(hostname, sizeof hostname - 1) == 0){
+        filename += hostname;
+    }else{
+        filename += "unknownhost";
+    }
+
+    char pidbuf[32];
+    snprintf(pidbuf, sizeof pidbuf, ".%d.log", ::getpid());
+    filename += pidbuf;
+    return filename;
+}
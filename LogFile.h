@@ -0,0 +1,37 @@
+#pragma once
+
+#include "noncopyable.h"
+#include <string>
+#include <stdio.h>
+#include <time.h>
+#include <sys/types.h>
+
+/**
+ * 滚动日志文件。按大小和自然日滚动，只由AsyncLogging的后台线程使用，不加锁
+*/
+class LogFile : noncopyable{
+public:
+    LogFile(const std::string& basename, off_t rollSize, int checkEveryN = 1024);
+    ~LogFile();
+
+    void append(const char* logline, size_t len);
+    void flush();
+    bool rollFile();
+
+private:
+    static std::string getLogFileName(const std::string& basename, time_t* now);
+
+    const std::string basename_;
+    const off_t rollSize_;
+    const int checkEveryN_;
+
+    int count_;
+    off_t writtenBytes_;
+    time_t startOfPeriod_;
+    time_t lastRoll_;
+
+    FILE* fp_;
+    char buffer_[64 * 1024];
+
+    static const int kRollPerSeconds = 60 * 60 * 24;
+};
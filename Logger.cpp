@@ -1,38 +1,85 @@
 #include "Logger.h"
 #include "TimeStamp.h"
-#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <stdarg.h>
 
 /**
- * 内部维护了一个static的logger变量，一个logLevel变量
+ * 内部维护了一个static的logger变量，一个static的原子阈值s_logLevel_
  * 
- * 使用logger：先获取静态logger对象，然后低啊用Logger::setLogLevel设置日志级别，然后调用log函数打印string信息
+ * 使用logger：LOG_xxx宏先用一次relaxed原子读比较阈值，过了阈值才获取静态logger对象，调用log(级别, 格式, 参数)，格式化只在这里做一次
+ *            编译期低于MYMUDUO_MIN_LOG_LEVEL的宏直接展开为空
  * 
  * 将上述使用logger的流程定义为宏，然后写在.h文件中，方便用户使用
+ * 
+ * 输出：log把 [级别]时间 : 消息 拼成一行交给output_。默认output_是fwrite到stdout（不再每条都std::endl强制刷新），
+ *      可以用setOutput换成AsyncLogging::append，由后台线程写滚动文件
 */
 
+namespace{
+
+void defaultOutput(const char* msg, size_t len){
+    ::fwrite(msg, 1, len, stdout);
+}
+
+void defaultFlush(){
+    ::fflush(stdout);
+}
+
+}
+
+std::atomic_int Logger::s_logLevel_(INFO);
+
+Logger::Logger() : output_(defaultOutput), flush_(defaultFlush){
+
+}
 
 Logger& Logger::getInstance(){
     static Logger logger;
     return logger;
 }
 
-void Logger::setLogLevel(LogLevel level){
-    logLevel_ = level;
+void Logger::setOutput(OutputFunc out){
+    output_ = out ? std::move(out) : OutputFunc(defaultOutput);
+}
+
+void Logger::setFlush(FlushFunc flush){
+    flush_ = flush ? std::move(flush) : FlushFunc(defaultFlush);
 }
 
-void Logger::log(std::string msg){
-    switch(logLevel_){
+void Logger::log(LogLevel logLevel, const char* fmt, ...){
+    const char* level = "";
+    switch(logLevel){
         case INFO: 
-            std::cout << "[INFO]"; break;
+            level = "[INFO]"; break;
         case DEBUG:
-            std::cout << "[DEBUG]"; break;
+            level = "[DEBUG]"; break;
         case FATAL:
-            std::cout << "[FATAL]"; break;
+            level = "[FATAL]"; break;
         case ERROR:
-            std::cout << "[ERROR]"; break;
+            level = "[ERROR]"; break;
         default:
              break;
     }
 
-    std::cout << TimeStamp::now().toString() << " : " << msg << std::endl;
-}
\ No newline at end of file
+    char line[1200];
+    int n = snprintf(line, sizeof line, "%s%s : ", level, TimeStamp::now().toString().c_str());
+    size_t len = std::min(static_cast<size_t>(n), sizeof line - 2);
+
+    va_list args;
+    va_start(args, fmt);
+    n = vsnprintf(line + len, sizeof line - len, fmt, args);
+    va_end(args);
+    if(n > 0){
+        len = std::min(len + n, sizeof line - 2);
+    }
+    if(line[len - 1] != '\n'){
+        line[len++] = '\n';
+    }
+    output_(line, len);
+
+    if(logLevel == FATAL){
+        flush_();
+    }
+}
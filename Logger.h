@@ -2,12 +2,25 @@
 
 #include "noncopyable.h"
 #include <string>
+#include <functional>
+#include <atomic>
+#include <stdlib.h>
+
+//编译期最低日志级别，低于它的LOG_xxx直接编译为空。可以用 -DMYMUDUO_MIN_LOG_LEVEL=2 只保留ERROR和FATAL
+#define MYMUDUO_LOG_LEVEL_DEBUG 0
+#define MYMUDUO_LOG_LEVEL_INFO 1
+#define MYMUDUO_LOG_LEVEL_ERROR 2
+#define MYMUDUO_LOG_LEVEL_FATAL 3
+
+#ifndef MYMUDUO_MIN_LOG_LEVEL
+#define MYMUDUO_MIN_LOG_LEVEL MYMUDUO_LOG_LEVEL_DEBUG
+#endif
 
 enum LogLevel{
-    DEBUG,
-    INFO,
-    ERROR,
-    FATAL
+    DEBUG = MYMUDUO_LOG_LEVEL_DEBUG,
+    INFO = MYMUDUO_LOG_LEVEL_INFO,
+    ERROR = MYMUDUO_LOG_LEVEL_ERROR,
+    FATAL = MYMUDUO_LOG_LEVEL_FATAL
 };
 
 class Logger : noncopyable{
@@ -15,56 +28,65 @@ public:
     //懒汉式单例模式
     static Logger& getInstance();
 
-    void setLogLevel(LogLevel);
+    //运行期阈值，低于它的日志在格式化之前就被过滤掉。任意线程可调用
+    static void setLogLevel(LogLevel level){
+        s_logLevel_.store(level, std::memory_order_relaxed);
+    }
 
-    void log(std::string msg);
+    static LogLevel logLevel(){
+        return static_cast<LogLevel>(s_logLevel_.load(std::memory_order_relaxed));
+    }
 
-private:
-    LogLevel logLevel_;
-    Logger() = default;
-};
+    //级别由每次调用传入，不再存放在单例里
+    void log(LogLevel level, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
 
+    //日志输出目的地，默认写stdout。接入AsyncLogging后，前台线程只做格式化和一次无锁拷贝
+    using OutputFunc = std::function<void(const char* msg, size_t len)>;
+    using FlushFunc = std::function<void()>;
+    //setOutput/setFlush不加锁，log()每次都直接读output_/flush_。只能在启动阶段、其他线程开始写日志之前调用；
+    //换回默认输出也要等别的线程都不再写日志之后（如AsyncLogging析构前）
+    void setOutput(OutputFunc out);
+    //FATAL退出进程前调用
+    void setFlush(FlushFunc flush);
 
+private:
+    static std::atomic_int s_logLevel_;
+    OutputFunc output_;
+    FlushFunc flush_;
+    Logger();
+};
 
-#define LOG_INFO(logmsgFormat, ...) \
+#define LOG_IMPL(level, logmsgFormat, ...) \
     do \
     { \
-        Logger &logger = Logger::getInstance(); \
-        logger.setLogLevel(INFO); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0) 
-
-#define LOG_DEBUG(logmsgFormat, ...) \
-    do\
-    {\
-        Logger &logger = Logger::getInstance(); \
-        logger.setLogLevel(DEBUG); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        if(Logger::logLevel() <= level) \
+        { \
+            Logger::getInstance().log(level, logmsgFormat, ##__VA_ARGS__); \
+        } \
     } while(0)
 
-#define LOG_ERROR(logmsgFormat, ...) \
-    do\
-    {\
-        Logger &logger = Logger::getInstance(); \
-        logger.setLogLevel(ERROR); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
-    } while(0)
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(logmsgFormat, ...) LOG_IMPL(DEBUG, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(logmsgFormat, ...) do { } while(0)
+#endif
 
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_INFO
+#define LOG_INFO(logmsgFormat, ...) LOG_IMPL(INFO, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_INFO(logmsgFormat, ...) do { } while(0)
+#endif
+
+#if MYMUDUO_MIN_LOG_LEVEL <= MYMUDUO_LOG_LEVEL_ERROR
+#define LOG_ERROR(logmsgFormat, ...) LOG_IMPL(ERROR, logmsgFormat, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(logmsgFormat, ...) do { } while(0)
+#endif
+
+//FATAL不受任何阈值过滤
 #define LOG_FATAL(logmsgFormat, ...) \
     do\
     {\
-        Logger &logger = Logger::getInstance(); \
-        logger.setLogLevel(FATAL); \
-        char buf[1024] = {0}; \
-        snprintf(buf, 1024, logmsgFormat, ##__VA_ARGS__); \
-        logger.log(buf); \
+        Logger::getInstance().log(FATAL, logmsgFormat, ##__VA_ARGS__); \
         exit(1); \
     } while(0)
-
-
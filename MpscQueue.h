@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include "noncopyable.h"
+
+/**
+ * 无锁的多生产者单消费者队列（无界，Vyukov的侵入式链表做法）
+ * 生产者只对head_做一次exchange，再把前一个节点的next指向新节点；消费者独占tail_，沿next往后取。
+ * 生产者在exchange和设置next之间被打断时，消费者会暂时看到队列在这里断开，pop返回false，
+ * 调用方需要在生产者完成push之后再有一次唤醒（见EventLoop::queueInLoop），不会丢任务。
+ *
+ * push可以在任意线程调用，pop只能在唯一的消费者线程调用
+*/
+template <typename T>
+class MpscQueue : noncopyable{
+public:
+    MpscQueue() : head_(new Node()), tail_(head_.load(std::memory_order_relaxed)){}
+
+    ~MpscQueue(){
+        T value;
+        while(pop(&value)){
+        }
+        delete tail_;
+    }
+
+    void push(T value){
+        Node* node = new Node(std::move(value));
+        Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    bool pop(T* value){
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if(next == nullptr){
+            return false;
+        }
+        //next成为新的哨兵节点，它的value已经被取走
+        *value = std::move(next->value);
+        tail_ = next;
+        delete tail;
+        return true;
+    }
+
+private:
+    struct Node{
+        Node() : next(nullptr){}
+        explicit Node(T&& v) : next(nullptr), value(std::move(v)){}
+        std::atomic<Node*> next;
+        T value;
+    };
+
+    std::atomic<Node*> head_;
+    Node* tail_;
+};
@@ -1,13 +1,27 @@
 #include "Poller.h"
 #include "Channel.h"
+#include <algorithm>
 
-Poller::Poller(EventLoop* loop): ownerLoop_(loop){
+Poller::Poller(EventLoop* loop): ownerLoop_(loop), ctlCalls_(0){
 
 }
 
 Poller::~Poller() = default;
 
 bool Poller::hasChannel(Channel* channel)const{
-    ChannelMap::const_iterator it = channels_.find(channel->fd());
-    return it != channels_.end() && it->second == channel;
+    return findChannel(channel->fd()) == channel;
+}
+
+void Poller::addChannel(Channel* channel){
+    size_t fd = channel->fd();
+    if(fd >= channels_.size()){
+        channels_.resize(std::max(fd + 1, channels_.size() * 2), nullptr);
+    }
+    channels_[fd] = channel;
+}
+
+void Poller::eraseChannel(int fd){
+    if(static_cast<size_t>(fd) < channels_.size()){
+        channels_[fd] = nullptr;
+    }
 }
\ No newline at end of file
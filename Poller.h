@@ -1,7 +1,8 @@
 #pragma once
 
-#include <unordered_map>
 #include <vector>
+#include <atomic>
+#include <stdint.h>
 
 #include "noncopyable.h"
 #include "TimeStamp.h"
@@ -26,10 +27,27 @@ public:
 
     static Poller* newDefaultPoller(EventLoop* loop);
 
+    //累计向内核提交的关注事件增删改次数（epoll_ctl调用数，io_uring为poll增删请求数），任意线程可读，按时间差求速率
+    uint64_t ctlCalls() const{
+        return ctlCalls_.load(std::memory_order_relaxed);
+    }
+
 protected:
-    using ChannelMap = std::unordered_map<int, Channel*>;
+    //以fd为下标的channel表，没有注册的fd为nullptr
+    using ChannelMap = std::vector<Channel*>;
     ChannelMap channels_;
 
+    Channel* findChannel(int fd) const{
+        return static_cast<size_t>(fd) < channels_.size() ? channels_[fd] : nullptr;
+    }
+    void addChannel(Channel* channel);
+    void eraseChannel(int fd);
+
+    void countCtl(){
+        ctlCalls_.fetch_add(1, std::memory_order_relaxed);
+    }
+
 private:
     EventLoop* ownerLoop_;
+    std::atomic<uint64_t> ctlCalls_;
 };
\ No newline at end of file
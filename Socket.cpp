@@ -8,6 +8,11 @@
 #include <netinet/in.h>
 #include <sys/types.h>
 #include <netinet/tcp.h>
+#include <errno.h>
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
 
 /**
  * 维护了一个sockFd：这个fd由外界传入。对于Acceptor，它的fd是整个baseLoop的listenFd，是由static::createNoBlock{ ::socket(...)} 直接创建的、
@@ -62,15 +67,32 @@ void Socket::setTcpNoDeley(bool on){
 
 void Socket::setReuseAddr(bool on){
     int optval = on ? 1 : 0;
-    ::setsockopt(sockfd_, IPPROTO_TCP, SO_REUSEADDR, &optval, sizeof(optval));
+    ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
 }
 
 void Socket::setReusePort(bool on){
     int optval = on ? 1 :0;
-    ::setsockopt(sockfd_, IPPROTO_TCP, SO_REUSEPORT, &optval, sizeof optval);
+    ::setsockopt(sockfd_, SOL_SOCKET, SO_REUSEPORT, &optval, sizeof optval);
+}
+
+bool Socket::setZeroCopy(bool on){
+    int optval = on ? 1 : 0;
+    if(::setsockopt(sockfd_, SOL_SOCKET, SO_ZEROCOPY, &optval, sizeof optval) < 0){
+        LOG_ERROR("setsockopt SO_ZEROCOPY fd %d fail, errno: %d", sockfd_, errno);
+        return false;
+    }
+    return true;
+}
+
+bool Socket::setBusyPoll(int usec){
+    if(::setsockopt(sockfd_, SOL_SOCKET, SO_BUSY_POLL, &usec, sizeof usec) < 0){
+        LOG_ERROR("setsockopt SO_BUSY_POLL fd %d fail, errno: %d", sockfd_, errno);
+        return false;
+    }
+    return true;
 }
 
 void Socket::setKeepAlive(bool on){
     int optval = on ? 1 : 0;
-    ::setsockopt(sockfd_, IPPROTO_TCP, SO_KEEPALIVE, &optval, sizeof optval);
+    ::setsockopt(sockfd_, SOL_SOCKET, SO_KEEPALIVE, &optval, sizeof optval);
 }
@@ -29,6 +29,12 @@ public:
 
     void setKeepAlive(bool on);
 
+    //SO_BUSY_POLL，阻塞读/poll这个socket时在驱动队列上忙等usec微秒。调大到超过net.core.busy_read需要CAP_NET_ADMIN，失败返回false
+    bool setBusyPoll(int usec);
+
+    //SO_ZEROCOPY，内核不支持时返回false
+    bool setZeroCopy(bool on);
+
 private:
     const int sockfd_;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <string.h>
+#include <strings.h>
+#include <stddef.h>
+
+/**
+ * 不拥有数据的只读字符串视图（C++11没有string_view），只在被指向的存储有效期间可用
+*/
+class StringPiece{
+public:
+    StringPiece() : data_(""), size_(0){}
+    StringPiece(const char* data, size_t size) : data_(data), size_(size){}
+    StringPiece(const char* str) : data_(str), size_(strlen(str)){}
+    StringPiece(const std::string& str) : data_(str.data()), size_(str.size()){}
+
+    const char* data() const{
+        return data_;
+    }
+    size_t size() const{
+        return size_;
+    }
+    bool empty() const{
+        return size_ == 0;
+    }
+
+    char operator[](size_t i) const{
+        return data_[i];
+    }
+
+    bool operator==(const StringPiece& rhs) const{
+        return size_ == rhs.size_ && memcmp(data_, rhs.data_, size_) == 0;
+    }
+    bool operator!=(const StringPiece& rhs) const{
+        return !(*this == rhs);
+    }
+
+    //忽略大小写比较，HTTP头名、token用
+    bool equalsIgnoreCase(const StringPiece& rhs) const{
+        return size_ == rhs.size_ && strncasecmp(data_, rhs.data_, size_) == 0;
+    }
+
+    std::string toString() const{
+        return std::string(data_, size_);
+    }
+
+private:
+    const char* data_;
+    size_t size_;
+};
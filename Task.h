@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * 只能移动的void()任务，代替std::function<void()>投递给EventLoop
+ * 可调用对象不超过kInlineSize字节（例如捕获一个TcpConnectionPtr再加几个指针/整数的bind或lambda）时直接放在内部缓冲里，
+ * 投递不需要分配内存；更大的才放到堆上。不要求可调用对象可拷贝，移动构造必须不抛异常才会内联存放
+*/
+class Task{
+public:
+    static const size_t kInlineSize = 64;
+
+    Task() : ops_(nullptr){}
+
+    Task(std::nullptr_t) : ops_(nullptr){}
+
+    template <typename F,
+              typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F&& f) : ops_(nullptr){
+        typedef typename std::decay<F>::type Fn;
+        construct<Fn>(std::forward<F>(f), std::integral_constant<bool, fitsInline<Fn>()>());
+    }
+
+    Task(Task&& other) : ops_(other.ops_){
+        if(ops_ != nullptr){
+            ops_->move(&storage_, &other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other){
+        if(this != &other){
+            reset();
+            if(other.ops_ != nullptr){
+                other.ops_->move(&storage_, &other.storage_);
+                ops_ = other.ops_;
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task& operator=(std::nullptr_t){
+        reset();
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task(){
+        reset();
+    }
+
+    void operator()() const{
+        ops_->invoke(const_cast<Storage*>(&storage_));
+    }
+
+    explicit operator bool() const{
+        return ops_ != nullptr;
+    }
+
+private:
+    typedef typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type Storage;
+
+    //按可调用对象的类型生成的一组函数，存放方式（内联/堆）也由它决定
+    struct Ops{
+        void (*invoke)(void* storage);
+        //从src移动到未初始化的dst，并销毁src
+        void (*move)(void* dst, void* src);
+        void (*destroy)(void* storage);
+    };
+
+    template <typename Fn>
+    static constexpr bool fitsInline(){
+        return sizeof(Fn) <= kInlineSize && alignof(std::max_align_t) % alignof(Fn) == 0
+            && std::is_nothrow_move_constructible<Fn>::value;
+    }
+
+    template <typename Fn>
+    struct InlineOps{
+        static void invoke(void* storage){
+            (*static_cast<Fn*>(storage))();
+        }
+        static void move(void* dst, void* src){
+            ::new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void destroy(void* storage){
+            static_cast<Fn*>(storage)->~Fn();
+        }
+        static const Ops ops;
+    };
+
+    template <typename Fn>
+    struct HeapOps{
+        static void invoke(void* storage){
+            (**static_cast<Fn**>(storage))();
+        }
+        static void move(void* dst, void* src){
+            *static_cast<Fn**>(dst) = *static_cast<Fn**>(src);
+        }
+        static void destroy(void* storage){
+            delete *static_cast<Fn**>(storage);
+        }
+        static const Ops ops;
+    };
+
+    template <typename Fn, typename F>
+    void construct(F&& f, std::true_type){
+        ::new (&storage_) Fn(std::forward<F>(f));
+        ops_ = &InlineOps<Fn>::ops;
+    }
+
+    template <typename Fn, typename F>
+    void construct(F&& f, std::false_type){
+        *reinterpret_cast<Fn**>(&storage_) = new Fn(std::forward<F>(f));
+        ops_ = &HeapOps<Fn>::ops;
+    }
+
+    void reset(){
+        if(ops_ != nullptr){
+            ops_->destroy(&storage_);
+            ops_ = nullptr;
+        }
+    }
+
+    Storage storage_;
+    const Ops* ops_;
+};
+
+template <typename Fn>
+const Task::Ops Task::InlineOps<Fn>::ops = {&Task::InlineOps<Fn>::invoke, &Task::InlineOps<Fn>::move, &Task::InlineOps<Fn>::destroy};
+
+template <typename Fn>
+const Task::Ops Task::HeapOps<Fn>::ops = {&Task::HeapOps<Fn>::invoke, &Task::HeapOps<Fn>::move, &Task::HeapOps<Fn>::destroy};
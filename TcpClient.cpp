@@ -0,0 +1,120 @@
+#include "TcpClient.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <string.h>
+#include <sys/socket.h>
+
+/**
+ * TcpClient：维护了一个Connector和它建立的当前连接connection_（其他线程可以取，用mutex保护）
+ * newConnection：Connector交出fd后在loop线程建立TcpConnection，关闭回调指回removeConnection
+ * removeConnection：清掉connection_，销毁连接；开启了重试且没有调用disconnect时让Connector重新连接
+ * 析构：连接可能被用户持有、比TcpClient活得久，先把它的关闭回调换成不依赖this的版本；
+ *       没有其他人持有就直接forceClose。Connector在loop线程里同步stop，之后不会再回调this
+*/
+
+static void removeDetachedConnection(const TcpConnectionPtr& conn){
+    conn->getLoop()->queueInLoop(std::bind(&TcpConnection::connectionDestroyed, conn));
+}
+
+static void defaultConnectionCallback(const TcpConnectionPtr& conn){
+    LOG_INFO("%s -> %s is %s\n", conn->localAddress().toIpPort().c_str(),
+        conn->peerAddress().toIpPort().c_str(), conn->connected() ? "UP" : "DOWN");
+}
+
+static void defaultMessageCallback(const TcpConnectionPtr&, Buffer* buf, TimeStamp){
+    buf->retrieveAll();
+}
+
+TcpClient::TcpClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name)
+    : loop_(loop), connector_(new Connector(loop, serverAddr)), name_(name),
+    connectionCallback_(defaultConnectionCallback), messageCallback_(defaultMessageCallback),
+    retry_(false), connect_(false), nextConnId_(1){
+    connector_->setNewConnectionCallback(std::bind(&TcpClient::newConnection, this, std::placeholders::_1));
+    LOG_INFO("TcpClient::TcpClient[%s] - connector %p\n", name_.c_str(), connector_.get());
+}
+
+TcpClient::~TcpClient(){
+    LOG_INFO("TcpClient::~TcpClient[%s] - connector %p\n", name_.c_str(), connector_.get());
+    TcpConnectionPtr conn;
+    bool unique = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        unique = connection_.unique();
+        conn = connection_;
+    }
+    if(conn){
+        loop_->runInLoop(std::bind(&TcpConnection::setCloseCallback, conn, CloseCallback(removeDetachedConnection)));
+        if(unique){
+            conn->forceClose();
+        }
+    }
+    connector_->stop();
+}
+
+void TcpClient::connect(){
+    LOG_INFO("TcpClient::connect[%s] - connecting to %s\n", name_.c_str(),
+        connector_->serverAddress().toIpPort().c_str());
+    connect_ = true;
+    connector_->start();
+}
+
+void TcpClient::disconnect(){
+    connect_ = false;
+    std::unique_lock<std::mutex> lock(mutex_);
+    if(connection_){
+        connection_->shutdown();
+    }
+}
+
+void TcpClient::stop(){
+    connect_ = false;
+    connector_->stop();
+}
+
+void TcpClient::newConnection(int sockfd){
+    sockaddr_in local, peer;
+    memset(&local, 0, sizeof local);
+    memset(&peer, 0, sizeof peer);
+    socklen_t addrlen = sizeof local;
+    if(::getsockname(sockfd, (sockaddr*)&local, &addrlen) < 0){
+        LOG_ERROR("sockets:getLocalAddr");
+    }
+    addrlen = sizeof peer;
+    if(::getpeername(sockfd, (sockaddr*)&peer, &addrlen) < 0){
+        LOG_ERROR("sockets:getPeerAddr");
+    }
+    InetAddress localAddr(local);
+    InetAddress peerAddr(peer);
+
+    char buf[64] = {0};
+    snprintf(buf, sizeof buf, ":%s#%d", peerAddr.toIpPort().c_str(), nextConnId_++);
+    std::string connName = name_ + buf;
+
+    TcpConnectionPtr conn(new TcpConnection(loop_, connName, sockfd, localAddr, peerAddr));
+    conn->setConnectionCallback(connectionCallback_);
+    conn->setMessageCallback(messageCallback_);
+    conn->setWriteCompleleCallback(writeCompleteCallback_);
+    conn->setCloseCallback(std::bind(&TcpClient::removeConnection, this, std::placeholders::_1));
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        connection_ = conn;
+    }
+    conn->connectionEstablished();
+}
+
+void TcpClient::removeConnection(const TcpConnectionPtr& conn){
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if(connection_ == conn){
+            connection_.reset();
+        }
+    }
+    loop_->queueInLoop(std::bind(&TcpConnection::connectionDestroyed, conn));
+    if(retry_ && connect_){
+        LOG_INFO("TcpClient::removeConnection[%s] - reconnecting to %s\n", name_.c_str(),
+            connector_->serverAddress().toIpPort().c_str());
+        connector_->restart();
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "noncopyable.h"
+#include "Callbacks.h"
+#include "Connector.h"
+#include "InetAddress.h"
+#include <string>
+#include <mutex>
+#include <atomic>
+
+class EventLoop;
+
+/**
+ * 客户端：用Connector连上serverAddr后建立TcpConnection，一个TcpClient同时只有一个连接。
+ * enableRetry后连接断开会自动重连。必须在loop线程析构
+*/
+class TcpClient : noncopyable{
+public:
+    TcpClient(EventLoop* loop, const InetAddress& serverAddr, const std::string& name);
+    ~TcpClient();
+
+    void connect();
+    //关闭写端，连接断开后不再重连
+    void disconnect();
+    //停止正在进行的连接和重试，已建立的连接不受影响
+    void stop();
+
+    TcpConnectionPtr connection(){
+        std::unique_lock<std::mutex> lock(mutex_);
+        return connection_;
+    }
+
+    EventLoop* getLoop() const{
+        return loop_;
+    }
+    const std::string& name() const{
+        return name_;
+    }
+
+    bool retry() const{
+        return retry_;
+    }
+    void enableRetry(){
+        retry_ = true;
+    }
+
+    void setConnectionCallback(const ConnectionCallback& cb){
+        connectionCallback_ = cb;
+    }
+    void setMessageCallback(const MessageCallback& cb){
+        messageCallback_ = cb;
+    }
+    void setWriteCompleteCallback(const WriteCompleteCallback& cb){
+        writeCompleteCallback_ = cb;
+    }
+
+private:
+    void newConnection(int sockfd);
+    void removeConnection(const TcpConnectionPtr& conn);
+
+    EventLoop* loop_;
+    ConnectorPtr connector_;
+    const std::string name_;
+    ConnectionCallback connectionCallback_;
+    MessageCallback messageCallback_;
+    WriteCompleteCallback writeCompleteCallback_;
+    std::atomic_bool retry_;
+    std::atomic_bool connect_;
+    int nextConnId_;
+    std::mutex mutex_;
+    TcpConnectionPtr connection_;
+};
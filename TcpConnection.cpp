@@ -5,6 +5,20 @@
 #include "Logger.h"
 #include "EventLoop.h"
 
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#include <string.h>
+#include <limits.h>
+
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
 /**
  * ScpConnection: 
  * 维护了一个Channel、一个socket、一对InetAddress（local和peer）、两个buffer
@@ -22,6 +36,13 @@
  *             2）如果第一次写不完，写不完的数据再存入buffer，然后开启channel的可写通知。一旦可写，则由handleWrite负责写入。如果本次写完所有数据，则
  *                关闭channel的可写通知。否则一直等待下次可写
  * 
+ * 文件发送：sendFile把文件区间作为OutputSegment排进segments_，handleWrite里用sendfile直接从page cache发到socket，不经过用户态
+ *         顺序保证：outputBuffer_里已有的数据先发；segment还没发完时send的数据追加到该segment的trailer，发完后换入outputBuffer_
+ *         CachedFilePtr由FileCache提供，可以跨loop共享，OutputSegment持有它直到发完
+ * 零拷贝：setZeroCopy开启SO_ZEROCOPY后，send(SharedPayload)超过阈值的payload也作为OutputSegment排队，用MSG_ZEROCOPY发送。
+ *         内核发完后往socket错误队列投递完成通知，epoll报EPOLLERR，走Channel的error回调 -> handleError -> handleZeroCopyCompletions，
+ *         按序号释放zeroCopyInflight_里的payload。小于阈值的payload退化为普通拷贝send
+ * 
  * 用户注册的：messageCallback、conncetionCallback、setWriteCompleteCallback
  * 
  * 关闭相关：shutDown(sockfd)，由socket负责。如果用户主动调用关闭，则会关闭。【这种关闭是单方面关闭。仅仅关闭服务端的写端】，此时还能收到客户端的消息。当客户端收到服务端
@@ -36,29 +57,73 @@
  * 
  * disconnecting状态：shutdown，关闭写端之后的状态，此时不可写，可读。
  * Connecting状态：TcpConnection的构造函数内初始化为正在连接
+ * 
+ * inputBuffer/outputBuffer：构造时不分配，存储来自所属loop的BufferPool，读空即归还，所以空闲连接不占Buffer内存
+ * 
+ * 读：handleRead按readHint_预留可写区，再readv到【可写区 + 所属loop共享的64K溢出缓冲】。inputBuffer_为空且没收过大数据时不预留，只读进溢出缓冲
+ *     readHint_根据每次实际读到的字节数自适应：溢出就翻倍，连续两次读得很少就减半，范围[kMinReadHint, kMaxReadHint]，
+ *     加上kCheapPrepend后落在pool的级别上，预留不会向上取整到更大的一级
+ *     readBudget_ > 0时，一次可读事件里循环读，直到读空（没读满提供的空间）或累计超过readBudget_字节，再统一回调一次onMessage
+ *     读关注由两个开关共同决定：用户的startRead/stopRead（reading_），和自动读背压（readPaused_）。
+ *     待发送字节数每次变化都检查水位：超过highWaterMark_记为高水位，开了背压就暂停读；降到lowWaterMark_以下恢复读并回调lowWaterMark。
+ *     边沿触发时暂停期间不会再有新的边沿，恢复读时主动读一次
+ * 
+ * 超时：idleEntry_和writeEntry_是嵌在conn里的时间轮节点，挂在所属loop的TimingWheel上，刷新不分配内存
+ *       空闲超时：每次读写都刷新，到期先shutdown，再过一个周期还没关掉就forceClose
+ *       写超时：outputBuffer_里有积压时启用，每次写出进展都刷新，积压清空就取消，到期说明对端长时间不读，直接forceClose
 */
 
+const size_t TcpConnection::kShrinkThreshold;
+const size_t TcpConnection::kMinReadHint;
+const size_t TcpConnection::kMaxReadHint;
+const size_t TcpConnection::kDefaultZeroCopyThreshold;
+
 TcpConnection::TcpConnection(EventLoop* loop, const std::string& name, int sockfd, const InetAddress& localAddr, 
                     const InetAddress& peerAddr)
             :loop_(loop), name_(name), socket_(new Socket(sockfd)), 
             channel_(new Channel(loop, sockfd)),
             state_(kConnecting),
+            reading_(false),
             localAddr_(localAddr),
             peerAddr_(peerAddr),
-            highWaterMark_(64 * 1024 * 1024){
+            highWaterMark_(64 * 1024 * 1024),
+            lowWaterMark_(0),
+            aboveHighWaterMark_(false),
+            readBackpressure_(false),
+            readPaused_(false),
+            inputBuffer_(loop->bufferPool()),
+            outputBuffer_(loop->bufferPool()),
+            zeroCopy_(false),
+            zeroCopyThreshold_(kDefaultZeroCopyThreshold),
+            zeroCopyNextSeq_(0),
+            idleTimeout_(0.0),
+            writeTimeout_(0.0),
+            readHint_(kMinReadHint),
+            smallReads_(0),
+            readBudget_(0),
+            autoCork_(false),
+            corked_(false),
+            loadCounted_(true),
+            reportedPendingBytes_(0){
       channel_->setReadCallback(std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
       channel_->setWriteCallback(std::bind(&TcpConnection::handleWrite, this));
       channel_->setCloseCallback(std::bind(&TcpConnection::handleClose, this));
       channel_->setErrorCallback(std::bind(&TcpConnection::handleError, this));
+
+      idleEntry_.setExpireCallback(std::bind(&TcpConnection::handleIdleTimeout, this));
+      writeEntry_.setExpireCallback(std::bind(&TcpConnection::handleWriteTimeout, this));
       
       LOG_INFO("TcpConnection::ctor[%s] at fd=%d\n", name_.c_str(), sockfd);
 
       socket_->setKeepAlive(true);
+      //构造时就计入所属loop的负载，这样同一批accept的连接分配时就能看到彼此
+      loop_->addConnectionLoad(1);
 }
 
 TcpConnection::~TcpConnection(){
    LOG_INFO("TcpConnection::dtor[%s] at fd=%d state=%d \n", 
         name_.c_str(), channel_->fd(), (int)state_);
+   releaseLoad();
 }
 
 void TcpConnection::send(const std::string& buf){
@@ -66,18 +131,167 @@ void TcpConnection::send(const std::string& buf){
       if(loop_->isInLoopThread()){
          sendInLoop(buf.c_str(), buf.size());
       }else{
-         loop_->runInLoop(std::bind(&TcpConnection::sendInLoop, this, buf.c_str(), buf.size()));
+         //调用方的buf可能在sendInLoop执行前就析构了，跨线程必须带一份拷贝
+         loop_->runInLoop(std::bind(&TcpConnection::sendStringInLoop, shared_from_this(), buf));
+      }
+   }
+}
+
+void TcpConnection::send(std::string&& buf){
+   if(state_ == kConnected){
+      if(loop_->isInLoopThread()){
+         sendInLoop(buf.data(), buf.size());
+      }else{
+         loop_->runInLoop(std::bind(&TcpConnection::sendStringInLoop, shared_from_this(), std::move(buf)));
+      }
+   }
+}
+
+/**
+ * 跨线程send(Buffer*)：连续模式的Buffer只把存储和读写位置搬进任务，连同连接指针刚好64字节，
+ * 内联放在Task里，投递时除了MPSC队列节点不再分配内存；到了loop线程再还原成Buffer交给sendBufferInLoop，
+ * 条件满足时仍然是和outputBuffer_交换存储，不拷贝数据
+ */
+struct TcpConnection::BufferSendTask{
+   BufferSendTask(TcpConnectionPtr c, Buffer* buf) : conn(std::move(c)), storage(buf->takeStorage()){}
+   BufferSendTask(BufferSendTask&&) = default;
+
+   void operator()(){
+      Buffer buf(std::move(storage));
+      conn->sendBufferInLoop(&buf);
+   }
+
+   TcpConnectionPtr conn;
+   Buffer::Storage storage;
+};
+
+//链式Buffer的slab放在deque里，没法拆出来，整个Buffer换到堆上带过去
+struct TcpConnection::ChainedBufferSendTask{
+   ChainedBufferSendTask(TcpConnectionPtr c, Buffer* buf) : conn(std::move(c)), buf(new Buffer(buf->pool())){
+      this->buf->swap(*buf);
+   }
+   ChainedBufferSendTask(ChainedBufferSendTask&&) = default;
+
+   void operator()(){
+      conn->sendBufferInLoop(buf.get());
+   }
+
+   TcpConnectionPtr conn;
+   std::unique_ptr<Buffer> buf;
+};
+
+void TcpConnection::send(Buffer* buf){
+   if(state_ == kConnected){
+      if(loop_->isInLoopThread()){
+         sendBufferInLoop(buf);
+      }else if(!buf->chained()){
+         loop_->runInLoop(BufferSendTask(shared_from_this(), buf));
+      }else{
+         loop_->runInLoop(ChainedBufferSendTask(shared_from_this(), buf));
+      }
+   }
+}
+
+void TcpConnection::send(const struct iovec* iov, int iovcnt){
+   if(state_ == kConnected){
+      if(loop_->isInLoopThread()){
+         sendvInLoop(iov, iovcnt);
+      }else{
+         //调用方的iov在返回后就可能失效，必须拷贝一次；按总长一次分配好，再走Buffer的投递路径
+         size_t total = 0;
+         for(int i = 0; i < iovcnt; ++i){
+            total += iov[i].iov_len;
+         }
+         Buffer gathered(loop_->bufferPool());
+         gathered.ensureWriteableBytes(total);
+         for(int i = 0; i < iovcnt; ++i){
+            gathered.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+         }
+         loop_->runInLoop(BufferSendTask(shared_from_this(), &gathered));
+      }
+   }
+}
+
+void TcpConnection::send(std::vector<std::string>&& pieces){
+   if(state_ == kConnected){
+      if(loop_->isInLoopThread()){
+         sendPiecesInLoop(pieces);
+      }else{
+         loop_->runInLoop(std::bind(&TcpConnection::sendPiecesInLoop, shared_from_this(), std::move(pieces)));
+      }
+   }
+}
+
+void TcpConnection::sendStringInLoop(const std::string& message){
+   sendInLoop(message.data(), message.size());
+}
+
+void TcpConnection::sendPiecesInLoop(const std::vector<std::string>& pieces){
+   std::vector<struct iovec> iov(pieces.size());
+   for(size_t i = 0; i < pieces.size(); ++i){
+      iov[i].iov_base = const_cast<char*>(pieces[i].data());
+      iov[i].iov_len = pieces[i].size();
+   }
+   sendvInLoop(iov.data(), static_cast<int>(iov.size()));
+}
+
+/**
+ * 发送Buffer：buf和outputBuffer_属于同一个pool、同一种模式，并且前面没有待发数据时，
+ * 先直接写一次，剩下的不拷贝，和outputBuffer_交换存储即可；否则退化为普通的sendInLoop
+ */
+void TcpConnection::sendBufferInLoop(Buffer* buf){
+   if(autoCork_ || buf->pool() != outputBuffer_.pool() || buf->chained() != outputBuffer_.chained()
+      || channel_->isWriting() || outputBuffer_.readableBytes() != 0 || !segments_.empty()){
+      sendInLoop(buf->peek(), buf->readableBytes());
+      buf->retrieveAll();
+      return;
+   }
+
+   int saveErrno = 0;
+   ssize_t n = buf->writeFd(socket_->fd(), &saveErrno);
+   if(n > 0){
+      buf->retrieve(n);
+      if(idleTimeout_ > 0){
+         loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+      }
+   }else if(n < 0 && saveErrno != EWOULDBLOCK){
+      LOG_ERROR("TcpConnection: send buffer in loop");
+      buf->retrieveAll();
+      return;
+   }
+
+   size_t remaining = buf->readableBytes();
+   if(remaining == 0){
+      if(writeCompleteCallback_){
+         loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
       }
+      return;
+   }
+   if(remaining > highWaterMark_ && highWaterMarkCallback_){
+      loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), remaining));
    }
+   outputBuffer_.swap(*buf);
+   waitForWritable();
+}
+
+void TcpConnection::sendInLoop(const void* message, size_t len){
+   struct iovec vec;
+   vec.iov_base = const_cast<void*>(message);
+   vec.iov_len = len;
+   sendvInLoop(&vec, 1);
 }
 
 /**
  * 发送数据  应用写的快， 而内核发送数据慢.
- * 首次发送使用char*，如果发送完了则没问题。
+ * 首次发送使用char*（多段数据用writev一次发出），如果发送完了则没问题。
  * 如果受到TCP滑动窗口限制等等，无法一次性写完所有数据，则剩下的数据保存到output_buffer，然后开启channel的写通知，
  * 一旦可写，就会调用事先绑定的write handle，利用buffer继续写
  */ 
-void TcpConnection::sendInLoop(const void* message, size_t len){
+void TcpConnection::sendvInLoop(const struct iovec* iov, int iovcnt){
+   size_t len = 0;
+   for(int i = 0; i < iovcnt; ++i){
+      len += iov[i].iov_len;
+   }
    ssize_t nwrote = 0;
    size_t remaining = len;
    bool faultError = false;
@@ -86,10 +300,29 @@ void TcpConnection::sendInLoop(const void* message, size_t len){
       LOG_ERROR("disconnected");
    }
 
-   if(!channel_->isWriting() && outputBuffer_.writeableBytes() == 0){
-      nwrote = ::write(socket_->fd(), message, len);
+   if(autoCork_ && !channel_->isWriting() && segments_.empty()){
+      //先攒在outputBuffer_里，本轮循环末尾flushCorked一次写出
+      size_t oldLen = outputBuffer_.readableBytes();
+      if(oldLen + len > highWaterMark_ && oldLen < highWaterMark_ && highWaterMarkCallback_){
+         loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + len));
+      }
+      for(int i = 0; i < iovcnt; ++i){
+         outputBuffer_.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+      }
+      if(!corked_ && outputBuffer_.readableBytes() > 0){
+         corked_ = true;
+         loop_->queueFlush(std::bind(&TcpConnection::flushCorked, shared_from_this()));
+      }
+      return;
+   }
+
+   if(!channel_->isWriting() && outputBuffer_.readableBytes() == 0 && segments_.empty()){
+      nwrote = ::writev(socket_->fd(), iov, std::min(iovcnt, IOV_MAX));
       if(nwrote >= 0){
          remaining = len - nwrote;
+         if(idleTimeout_ > 0){
+            loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+         }
          if(remaining == 0 && writeCompleteCallback_){
             loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
          }
@@ -103,15 +336,204 @@ void TcpConnection::sendInLoop(const void* message, size_t len){
    }
 
    if(!faultError && remaining > 0){
-      size_t oldLen = outputBuffer_.readableBytes();
+      //前面还有文件/零拷贝payload没发完的话，数据要排在它们后面
+      Buffer* output = segments_.empty() ? &outputBuffer_ : &segments_.back().trailer;
+      size_t oldLen = output->readableBytes();
       if(oldLen + remaining > highWaterMark_ && oldLen < highWaterMark_
          && highWaterMarkCallback_){
             loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), oldLen + remaining));
       }
-      outputBuffer_.append((char*)message + nwrote, remaining);
-      if(!channel_->isWriting()){
-         channel_->enableWriting();
+      size_t skip = nwrote;
+      for(int i = 0; i < iovcnt; ++i){
+         const char* base = static_cast<const char*>(iov[i].iov_base);
+         size_t n = iov[i].iov_len;
+         if(skip >= n){
+            skip -= n;
+            continue;
+         }
+         output->append(base + skip, n - skip);
+         skip = 0;
+      }
+      waitForWritable();
+   }
+}
+
+void TcpConnection::sendFile(int fd, off_t offset, size_t length){
+   sendFile(CachedFilePtr(), fd, offset, length);
+}
+
+void TcpConnection::sendFile(const CachedFilePtr& file, off_t offset, size_t length){
+   sendFile(file, file->fd(), offset, length);
+}
+
+void TcpConnection::sendFile(const CachedFilePtr& file, int fd, off_t offset, size_t length){
+   if(state_ == kConnected){
+      if(loop_->isInLoopThread()){
+         sendFileInLoop(file, fd, offset, length);
+      }else{
+         loop_->runInLoop(std::bind(&TcpConnection::sendFileInLoop, shared_from_this(), file, fd, offset, length));
+      }
+   }
+}
+
+/**
+ * 发送文件：outputBuffer_和之前的segment都发完了，就直接sendfile；发不完的部分作为OutputSegment排队，
+ * 由handleWrite在可写时继续sendfile
+ */
+void TcpConnection::sendFileInLoop(const CachedFilePtr& file, int fd, off_t offset, size_t length){
+   if(state_ == kDisconnected){
+      LOG_ERROR("disconnected, give up sending file");
+      return;
+   }
+
+   segments_.emplace_back(loop_->bufferPool(), OutputSegment::kFile, offset, length);
+   segments_.back().file = file;
+   segments_.back().fd = fd;
+   startSegment();
+}
+
+void TcpConnection::send(const SharedPayload& payload){
+   if(state_ == kConnected){
+      if(loop_->isInLoopThread()){
+         sendPayloadInLoop(payload);
+      }else{
+         loop_->runInLoop(std::bind(&TcpConnection::sendPayloadInLoop, shared_from_this(), payload));
+      }
+   }
+}
+
+void TcpConnection::sendPayloadInLoop(const SharedPayload& payload){
+   if(!zeroCopy_ || payload->size() < zeroCopyThreshold_){
+      sendInLoop(payload->data(), payload->size());
+      return;
+   }
+   if(state_ == kDisconnected){
+      LOG_ERROR("disconnected, give up writing");
+      return;
+   }
+
+   segments_.emplace_back(loop_->bufferPool(), OutputSegment::kZeroCopy, 0, payload->size());
+   segments_.back().payload = payload;
+   startSegment();
+}
+
+bool TcpConnection::setZeroCopy(bool on, size_t threshold){
+   if(!socket_->setZeroCopy(on)){
+      return false;
+   }
+   zeroCopy_ = on;
+   zeroCopyThreshold_ = threshold;
+   return true;
+}
+
+void TcpConnection::startSegment(){
+   OutputSegment& segment = segments_.back();
+   segment.trailer.setChained(outputBuffer_.chained());
+
+   if(!channel_->isWriting() && outputBuffer_.readableBytes() == 0 && segments_.size() == 1){
+      bool progress = false;
+      if(sendSegment(&segment, &progress)){
+         finishFrontSegment();
+      }
+      if(progress && idleTimeout_ > 0){
+         loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+      }
+      if(segments_.empty() && outputBuffer_.readableBytes() == 0){
+         if(writeCompleteCallback_){
+            loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+         }
+         return;
+      }
+   }
+
+   waitForWritable();
+}
+
+void TcpConnection::waitForWritable(){
+   if(!channel_->isWriting()){
+      channel_->enableWriting();
+   }
+   if(writeTimeout_ > 0 && !writeEntry_.scheduled()){
+      loop_->timingWheel()->schedule(&writeEntry_, writeTimeout_);
+   }
+   reportPendingBytes();
+}
+
+void TcpConnection::reportPendingBytes(){
+   size_t pending = outputBuffer_.readableBytes();
+   for(const OutputSegment& segment : segments_){
+      pending += segment.remaining + segment.trailer.readableBytes();
+   }
+   if(pending != reportedPendingBytes_){
+      loop_->addPendingBytes(static_cast<int64_t>(pending) - static_cast<int64_t>(reportedPendingBytes_));
+      reportedPendingBytes_ = pending;
+      checkWaterMarks(pending);
+   }
+}
+
+void TcpConnection::checkWaterMarks(size_t pending){
+   if(!aboveHighWaterMark_ && pending > highWaterMark_){
+      aboveHighWaterMark_ = true;
+      if(readBackpressure_ && !readPaused_){
+         readPaused_ = true;
+         updateReadInterest();
+      }
+   }else if(aboveHighWaterMark_ && pending <= lowWaterMark_){
+      aboveHighWaterMark_ = false;
+      if(readPaused_){
+         readPaused_ = false;
+         updateReadInterest();
+      }
+      if(lowWaterMarkCallback_){
+         loop_->queueInLoop(std::bind(lowWaterMarkCallback_, shared_from_this()));
+      }
+   }
+}
+
+void TcpConnection::startRead(){
+   loop_->runInLoop(std::bind(&TcpConnection::startReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::stopRead(){
+   loop_->runInLoop(std::bind(&TcpConnection::stopReadInLoop, shared_from_this()));
+}
+
+void TcpConnection::startReadInLoop(){
+   if(!reading_){
+      reading_ = true;
+      updateReadInterest();
+   }
+}
+
+void TcpConnection::stopReadInLoop(){
+   if(reading_){
+      reading_ = false;
+      updateReadInterest();
+   }
+}
+
+void TcpConnection::updateReadInterest(){
+   if(state_ != kConnected && state_ != kDisconnecting){
+      return;
+   }
+   bool want = reading_ && !readPaused_;
+   if(want == channel_->isReading()){
+      return;
+   }
+   if(want){
+      channel_->enableReading();
+      //边沿触发下暂停期间到达的数据不会再产生新的边沿，恢复时主动读一次
+      if(channel_->edgeTriggered()){
+         loop_->queueInLoop(std::bind(&TcpConnection::resumeEdgeTriggeredRead, shared_from_this()));
       }
+   }else{
+      channel_->disableReading();
+   }
+}
+
+void TcpConnection::resumeEdgeTriggeredRead(){
+   if((state_ == kConnected || state_ == kDisconnecting) && channel_->isReading()){
+      handleRead(TimeStamp::now());
    }
 }
 
@@ -122,16 +544,96 @@ void TcpConnection::shutdown(){
    }
 }
 
+void TcpConnection::flushCorked(){
+   corked_ = false;
+   //已经在等可写事件的话，handleWrite会接着写
+   if(state_ == kDisconnected || channel_->isWriting() || outputBuffer_.readableBytes() == 0){
+      return;
+   }
+
+   int saveErrno = 0;
+   ssize_t n = outputBuffer_.writeFd(channel_->fd(), &saveErrno);
+   if(n > 0){
+      outputBuffer_.retrieve(n);
+      if(idleTimeout_ > 0){
+         loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+      }
+   }else if(n < 0 && saveErrno != EWOULDBLOCK){
+      //真正的写错误：攒着的数据和cork期间推迟的shutdown都没有意义了，直接关闭连接
+      LOG_ERROR("TcpConnection::flushCorked [%s] errno=%d\n", name_.c_str(), saveErrno);
+      handleClose();
+      return;
+   }
+
+   if(outputBuffer_.readableBytes() == 0 && segments_.empty()){
+      if(writeCompleteCallback_){
+         loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+      }
+      if(state_ == kDisconnecting){
+         shutdownInLoop();
+      }
+      return;
+   }
+   waitForWritable();
+}
+
 void TcpConnection::shutdownInLoop(){
+   //还有没刷出的cork数据，等flushCorked写完再关
+   if(corked_){
+      return;
+   }
    if(!channel_->isWriting()){
       socket_->shutdownWrite();
    }
 }
 
+void TcpConnection::forceClose(){
+   if(state_ == kConnected || state_ == kDisconnecting){
+      setState(kDisconnecting);
+      loop_->queueInLoop(std::bind(&TcpConnection::forceCloseInLoop, shared_from_this()));
+   }
+}
+
+void TcpConnection::forceCloseInLoop(){
+   if(state_ == kConnected || state_ == kDisconnecting){
+      handleClose();
+   }
+}
+
+void TcpConnection::handleIdleTimeout(){
+   LOG_INFO("TcpConnection::handleIdleTimeout [%s] state=%d\n", name_.c_str(), (int)state_);
+   if(state_ == kConnected){
+      shutdown();
+      loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+   }else{
+      forceClose();
+   }
+}
+
+void TcpConnection::handleWriteTimeout(){
+   LOG_INFO("TcpConnection::handleWriteTimeout [%s] pending=%lu\n", name_.c_str(), outputBuffer_.readableBytes());
+   forceClose();
+}
+
+void TcpConnection::cancelTimeouts(){
+   if(idleEntry_.scheduled() || writeEntry_.scheduled()){
+      TimingWheel* wheel = loop_->timingWheel();
+      wheel->cancel(&idleEntry_);
+      wheel->cancel(&writeEntry_);
+   }
+}
+
 void TcpConnection::connectionEstablished(){
    setState(kConnected);
+   if(loop_->socketBusyPollUs() > 0){
+      socket_->setBusyPoll(loop_->socketBusyPollUs());
+   }
    channel_->tie(shared_from_this());
+   reading_ = true;
    channel_->enableReading();
+   if(idleTimeout_ > 0){
+      loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+   }
 
    connectionCallback_(shared_from_this());
 }
@@ -142,51 +644,259 @@ void TcpConnection::connectionDestroyed(){
       channel_->disableAll();
       connectionCallback_(shared_from_this());
    }
+   cancelTimeouts();
    channel_->remove();
+   releaseLoad();
+}
+
+void TcpConnection::releaseLoad(){
+   if(loadCounted_){
+      loadCounted_ = false;
+      loop_->addConnectionLoad(-1);
+      loop_->addPendingBytes(-static_cast<int64_t>(reportedPendingBytes_));
+      reportedPendingBytes_ = 0;
+   }
+}
+
+void TcpConnection::setEdgeTriggered(bool on){
+   channel_->setEdgeTriggered(on);
 }
 
 void TcpConnection::handleRead(TimeStamp receiveTime){
    int saveErrno = 0;
-   ssize_t n = inputBuffer_.readFd(channel_->fd(), &saveErrno);
-   if(n > 0){
+   size_t total = 0;
+   ssize_t n = 0;
+   bool capped = false;
+   do{
+      //空的inputBuffer_不预先向pool要块，数据先读进溢出缓冲，读到了才按实际大小append；
+      //EOF、EAGAIN和零星的小消息因此不会取一块再立刻还回去。只有溢出过（readHint_长大了）才说明在收大数据，提前预留
+      const bool reserve = inputBuffer_.readableBytes() != 0 || readHint_ > kMinReadHint;
+      if(reserve){
+         inputBuffer_.ensureWriteableBytes(readHint_);
+      }
+      const size_t writable = inputBuffer_.writeableBytes();
+      n = inputBuffer_.readFd(channel_->fd(), &saveErrno, loop_->overflowBuffer(), EventLoop::kOverflowBufferSize);
+      if(n <= 0){
+         break;
+      }
+      total += n;
+      //没预留时按readHint_判断是否“装不下”，否则每次都算溢出
+      adjustReadHint(n, reserve ? writable : readHint_);
+      //读背压下边沿触发也不能一次把内核缓冲读空，读够一个高水位先交给用户处理，剩下的在本轮任务里接着读，暂停了就等恢复时再读
+      if(readBackpressure_ && channel_->edgeTriggered() && total >= highWaterMark_){
+         capped = true;
+         break;
+      }
+      //没读满本次提供的空间，一般说明内核缓冲已经读空，不必再多一次返回EAGAIN的read。
+      //边沿触发不能依赖这个判断（读的同时可能有新数据到达而不再有新的边沿），必须读到EAGAIN
+      if(!channel_->edgeTriggered() && static_cast<size_t>(n) < writable + EventLoop::kOverflowBufferSize){
+         break;
+      }
+   }while(total < readBudget_ || channel_->edgeTriggered());
+
+   if(total > 0){
+      if(idleTimeout_ > 0){
+         loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+      }
       messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
-   }else if(n == 0){
+      //收过一次大消息后只剩少量半包数据，把长大的存储换成小块
+      size_t capacity = inputBuffer_.internalCapacity();
+      if(capacity > kShrinkThreshold && inputBuffer_.readableBytes() < capacity / 4){
+         inputBuffer_.shrink(0);
+      }
+      if(capped){
+         loop_->queueInLoop(std::bind(&TcpConnection::resumeEdgeTriggeredRead, shared_from_this()));
+      }
+   }
+   if(n == 0){
       handleClose();
-   }else{
+   }else if(n < 0 && saveErrno != EWOULDBLOCK){
       errno = saveErrno;
       LOG_ERROR("handle read");
       handleError();
    }
 }
 
+void TcpConnection::adjustReadHint(size_t n, size_t writable){
+   if(n > writable){
+      //可写区装不下，溢出到了loop的共享缓冲，下次预留更大的可写区。readHint_ + kCheapPrepend始终是2的幂
+      readHint_ = std::min(readHint_ * 2 + Buffer::kCheapPrepend, kMaxReadHint);
+      smallReads_ = 0;
+   }else if(n < readHint_ / 4 && ++smallReads_ >= 2){
+      readHint_ = std::max((readHint_ + Buffer::kCheapPrepend) / 2 - Buffer::kCheapPrepend, kMinReadHint);
+      smallReads_ = 0;
+   }
+}
+
 void TcpConnection::handleWrite(){
    if(channel_->isWriting()){
       int saveErrno = 0;
-      ssize_t n = outputBuffer_.writeFd(channel_->fd(), &saveErrno);
-      if(n > 0){
-         outputBuffer_.retrieve(n);
-         if(outputBuffer_.readableBytes() == 0){
-            channel_->disableWriting();
-            if(writeCompleteCallback_){
-               loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+      bool progress = false;
+      bool blocked = false;
+      //按顺序发：outputBuffer_ -> 第一个segment -> 第一个segment之后send的数据（换入outputBuffer_）-> 第二个segment ...
+      while(!blocked){
+         if(outputBuffer_.readableBytes() > 0){
+            ssize_t n = outputBuffer_.writeFd(channel_->fd(), &saveErrno);
+            if(n > 0){
+               outputBuffer_.retrieve(n);
+               progress = true;
+            }else if(saveErrno != EWOULDBLOCK){
+               LOG_ERROR("TcpConnection::handleWrite");
             }
-            if(state_ == kDisconnecting){
-               shutdownInLoop();
+            if(outputBuffer_.readableBytes() > 0){
+               blocked = true;
+               break;
+            }
+         }
+         if(segments_.empty()){
+            break;
+         }
+         if(!sendSegment(&segments_.front(), &progress)){
+            blocked = true;
+            break;
+         }
+         finishFrontSegment();
+      }
+
+      if(progress){
+         if(idleTimeout_ > 0){
+            loop_->timingWheel()->schedule(&idleEntry_, idleTimeout_);
+         }
+         if(writeTimeout_ > 0){
+            if(blocked){
+               loop_->timingWheel()->schedule(&writeEntry_, writeTimeout_);
+            }else{
+               loop_->timingWheel()->cancel(&writeEntry_);
             }
          }
-      }else {
-         LOG_ERROR("TcpConnection::handleWrite");
+         reportPendingBytes();
+      }
+      if(!blocked){
+         channel_->disableWriting();
+         if(writeCompleteCallback_){
+            loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+         }
+         if(state_ == kDisconnecting){
+            shutdownInLoop();
+         }
       }
    }else{
        LOG_ERROR("TcpConnection fd=%d is down, no more writing \n", channel_->fd());
    }
 }
 
+bool TcpConnection::sendSegment(OutputSegment* segment, bool* progress){
+   if(segment->type == OutputSegment::kFile){
+      return sendFileSegment(segment, progress);
+   }
+   return sendZeroCopySegment(segment, progress);
+}
+
+void TcpConnection::finishFrontSegment(){
+   Buffer& trailer = segments_.front().trailer;
+   if(outputBuffer_.readableBytes() == 0){
+      outputBuffer_.swap(trailer);
+   }else{
+      outputBuffer_.append(trailer.peek(), trailer.readableBytes());
+   }
+   segments_.pop_front();
+}
+
+bool TcpConnection::sendFileSegment(OutputSegment* segment, bool* progress){
+   while(segment->remaining > 0){
+      ssize_t n = ::sendfile(socket_->fd(), segment->fd, &segment->offset, segment->remaining);
+      if(n > 0){
+         segment->remaining -= n;
+         *progress = true;
+      }else if(n == 0){
+         //文件被截断：已承诺的长度无法兑现，对端的帧已不完整，只能断开
+         LOG_ERROR("TcpConnection::sendFile [%s] fd=%d hit EOF with %lu bytes left\n",
+            name_.c_str(), segment->fd, segment->remaining);
+         forceClose();
+         return false;
+      }else if(errno == EINTR){
+         continue;
+      }else{
+         if(errno != EWOULDBLOCK){
+            LOG_ERROR("TcpConnection::sendFile [%s] errno=%d\n", name_.c_str(), errno);
+            forceClose();
+         }
+         return false;
+      }
+   }
+   return true;
+}
+
+bool TcpConnection::sendZeroCopySegment(OutputSegment* segment, bool* progress){
+   const char* data = segment->payload->data();
+   while(segment->remaining > 0){
+      ssize_t n = ::send(socket_->fd(), data + segment->offset, segment->remaining, MSG_ZEROCOPY);
+      if(n > 0){
+         segment->offset += n;
+         segment->remaining -= n;
+         *progress = true;
+         //同一个payload的多次send只需记住最后一个序号
+         uint32_t seq = zeroCopyNextSeq_++;
+         if(!zeroCopyInflight_.empty() && zeroCopyInflight_.back().second == segment->payload){
+            zeroCopyInflight_.back().first = seq;
+         }else{
+            zeroCopyInflight_.emplace_back(seq, segment->payload);
+         }
+      }else if(n < 0 && errno == ENOBUFS){
+         //超过optmem限制，剩下的退化为普通拷贝发送
+         outputBuffer_.append(data + segment->offset, segment->remaining);
+         segment->remaining = 0;
+      }else if(n < 0 && errno == EINTR){
+         continue;
+      }else{
+         //和sendfile一样：真正的错误重试也不会成功，segment会一直卡在队首，直接断开
+         if(n < 0 && errno != EWOULDBLOCK){
+            LOG_ERROR("TcpConnection::sendZeroCopy [%s] errno=%d\n", name_.c_str(), errno);
+            forceClose();
+         }
+         return false;
+      }
+   }
+   return true;
+}
+
+void TcpConnection::handleZeroCopyCompletions(){
+   char control[128];
+   for(;;){
+      struct msghdr msg;
+      memset(&msg, 0, sizeof msg);
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof control;
+      if(::recvmsg(socket_->fd(), &msg, MSG_ERRQUEUE) < 0){
+         if(errno != EAGAIN && errno != EWOULDBLOCK){
+            LOG_ERROR("TcpConnection::handleZeroCopyCompletions [%s] errno=%d\n", name_.c_str(), errno);
+         }
+         break;
+      }
+      for(struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)){
+         if(!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+            || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))){
+            continue;
+         }
+         struct sock_extended_err* serr = reinterpret_cast<struct sock_extended_err*>(CMSG_DATA(cm));
+         if(serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0){
+            continue;
+         }
+         //TCP的完成通知按序号递增返回，[ee_info, ee_data]之前的send都已完成
+         uint32_t hi = serr->ee_data;
+         while(!zeroCopyInflight_.empty()
+            && static_cast<int32_t>(hi - zeroCopyInflight_.front().first) >= 0){
+            zeroCopyInflight_.pop_front();
+         }
+      }
+   }
+}
 
 void TcpConnection::handleClose(){
     LOG_INFO("TcpConnection::handleClose fd=%d state=%d \n", channel_->fd(), (int)state_);
     setState(kDisconnected);
     channel_->disableAll();
+    cancelTimeouts();
 
     TcpConnectionPtr connPtr(shared_from_this());
     connectionCallback_(connPtr); // 执行连接关闭的回调
@@ -195,6 +905,9 @@ void TcpConnection::handleClose(){
 
 
 void TcpConnection::handleError(){
+    if(zeroCopy_){
+        handleZeroCopyCompletions();
+    }
     int optval;
     socklen_t optlen = sizeof optval;
     int err = 0;
@@ -206,5 +919,8 @@ void TcpConnection::handleError(){
     {
         err = optval;
     }
-    LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d \n", name_.c_str(), err);
+    //零拷贝完成通知也会触发EPOLLERR，这时SO_ERROR为0，不是真正的错误
+    if(err != 0 || !zeroCopy_){
+        LOG_ERROR("TcpConnection::handleError name:%s - SO_ERROR:%d \n", name_.c_str(), err);
+    }
 }
\ No newline at end of file
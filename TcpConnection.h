@@ -4,7 +4,13 @@
 #include "InetAddress.h"
 #include "Callbacks.h"
 #include "Buffer.h"
+#include "TimingWheel.h"
+#include "FileCache.h"
 #include <string>
+#include <list>
+#include <deque>
+#include <vector>
+#include <sys/uio.h>
 #include <atomic>
 #include <memory>
 
@@ -38,9 +44,78 @@ public:
         return state_ == kConnected;
     }
 
+    Buffer* inputBuffer(){
+        return &inputBuffer_;
+    }
+
+    Buffer* outputBuffer(){
+        return &outputBuffer_;
+    }
+
     void send(const std::string& buf);
+    //跨线程时把buf移动进loop，不拷贝
+    void send(std::string&& buf);
+    //取走buf里的全部数据，buf被清空。本loop线程且outputBuffer_为空时，没写完的部分连同存储直接换进outputBuffer_；
+    //跨线程时把buf的存储O(1)换出来带进loop
+    void send(Buffer* buf);
+    //多段数据一次writev发出。数据不归连接所有，跨线程调用时会先拼成一个string
+    void send(const struct iovec* iov, int iovcnt);
+    //多段数据一次writev发出，跨线程时整个vector移动进loop
+    void send(std::vector<std::string>&& pieces);
+
+    //用sendfile零拷贝发送文件的[offset, offset + length)，和send的数据保持先后顺序，发完后回调writeComplete
+    //fd由调用方保证在发完之前不被关闭；用CachedFilePtr则由连接持有到发完
+    void sendFile(int fd, off_t offset, size_t length);
+    void sendFile(const CachedFilePtr& file, off_t offset, size_t length);
+
+    //payload由连接共享持有，不拷贝。开启零拷贝且大小超过阈值时用MSG_ZEROCOPY发送，内核确认发完后才释放；否则退化为普通send
+    void send(const SharedPayload& payload);
+
+    static const size_t kDefaultZeroCopyThreshold = 10 * 1024;
+
+    //开启SO_ZEROCOPY，只在本loop线程调用（如connectionCallback里）。内核不支持时返回false
+    bool setZeroCopy(bool on, size_t threshold = kDefaultZeroCopyThreshold);
 
     void shutdown();
+    void forceClose();
+
+    //开始/停止关注可读事件，任意线程调用。停止期间数据留在内核缓冲里，对端会被TCP流控挡住
+    void startRead();
+    void stopRead();
+    bool isReading() const{
+        return reading_;
+    }
+
+    //0表示不启用。必须在connectionEstablished之前设置
+    void setIdleTimeout(double seconds){
+        idleTimeout_ = seconds;
+    }
+
+    void setWriteTimeout(double seconds){
+        writeTimeout_ = seconds;
+    }
+
+    //一次可读事件里循环读到内核缓冲读空为止，最多读budget字节。0表示每次事件只读一次
+    void setReadBudget(size_t budget){
+        readBudget_ = budget;
+    }
+
+    //边沿触发：读写都做到内核缓冲读空/写满为止，EPOLLOUT常驻，epoll_ctl只在建立和关闭时调用。
+    //开启后readBudget不再限制单次读取量。必须在connectionEstablished之前设置
+    void setEdgeTriggered(bool on);
+
+    //auto-cork：本loop线程里的send只追加到outputBuffer_，本轮循环末尾统一写一次。必须在connectionEstablished之前设置
+    void setAutoCork(bool on){
+        autoCork_ = on;
+    }
+
+    //上层协议挂在连接上的状态（如HttpContext），只在本loop线程访问
+    void setContext(const std::shared_ptr<void>& context){
+        context_ = context;
+    }
+    const std::shared_ptr<void>& getContext() const{
+        return context_;
+    }
 
     void setConnectionCallback(const ConnectionCallback& cb){
         connectionCallback_ = cb;
@@ -58,6 +133,23 @@ public:
         highWaterMarkCallback_ = cb;
     }
 
+    //待发送数据超过high时回调highWaterMark，之后降到low以下回调lowWaterMark。只在本loop线程调用（如connectionCallback里）
+    void setWaterMarks(size_t high, size_t low){
+        highWaterMark_ = high;
+        lowWaterMark_ = low;
+    }
+
+    //典型用法是代理：一端的highWaterMark里stopRead另一端，lowWaterMark里再startRead
+    void setLowWaterMarkCallback(const WriteCompleteCallback& cb){
+        lowWaterMarkCallback_ = cb;
+    }
+
+    //自动读背压：本连接待发送的数据超过高水位时停止读本连接，降到低水位以下再恢复，适合请求-响应式的服务。
+    //和startRead/stopRead独立，两者都允许时才读
+    void setReadBackpressure(bool on){
+        readBackpressure_ = on;
+    }
+
     void setCloseCallback(const CloseCallback& cb){
         closeCallback_ = cb;
     }
@@ -70,6 +162,11 @@ public:
 private:
     enum StateE {kDisconnected, kConnected, kConnecting, kDisconnecting};
 
+    static const size_t kShrinkThreshold = 64 * 1024;
+    //预留时还要加上kCheapPrepend，两端都取 pool级别 - kCheapPrepend，最大的预留正好是一块64K，不会进到256K那一级
+    static const size_t kMinReadHint = 2 * 1024 - Buffer::kCheapPrepend;
+    static const size_t kMaxReadHint = 64 * 1024 - Buffer::kCheapPrepend;
+
     void setState(StateE state){ 
         state_ = state;
     }
@@ -79,8 +176,63 @@ private:
     void handleClose();
     void handleError();
 
+    void adjustReadHint(size_t n, size_t writable);
+
+    //排在outputBuffer_之后、不经过用户态拷贝的一段输出：文件区间，或MSG_ZEROCOPY发送的payload
+    //trailer是这一段发送期间又send进来的数据，这一段发完后换入outputBuffer_
+    struct OutputSegment{
+        enum Type {kFile, kZeroCopy};
+        OutputSegment(BufferPool* pool, Type t, off_t offsetArg, size_t length)
+            : type(t), fd(-1), offset(offsetArg), remaining(length), trailer(pool){}
+        Type type;
+        CachedFilePtr file;
+        int fd;
+        SharedPayload payload;
+        off_t offset;
+        size_t remaining;
+        Buffer trailer;
+    };
+
+    //跨线程send(Buffer*)投递的任务，定义在TcpConnection.cpp
+    struct BufferSendTask;
+    struct ChainedBufferSendTask;
+
     void sendInLoop(const void* message, size_t len);
+    void sendvInLoop(const struct iovec* iov, int iovcnt);
+    void sendStringInLoop(const std::string& message);
+    void sendPiecesInLoop(const std::vector<std::string>& pieces);
+    void sendBufferInLoop(Buffer* buf);
+    void sendPayloadInLoop(const SharedPayload& payload);
+    void sendFile(const CachedFilePtr& file, int fd, off_t offset, size_t length);
+    void sendFileInLoop(const CachedFilePtr& file, int fd, off_t offset, size_t length);
+    //新的segment已经放进segments_队尾，前面没有待发数据就立即尝试发送，否则等handleWrite
+    void startSegment();
+    //返回true表示这一段发完了
+    bool sendSegment(OutputSegment* segment, bool* progress);
+    bool sendFileSegment(OutputSegment* segment, bool* progress);
+    bool sendZeroCopySegment(OutputSegment* segment, bool* progress);
+    void finishFrontSegment();
+    //从socket的错误队列读取MSG_ZEROCOPY完成通知，释放已完成的payload
+    void handleZeroCopyCompletions();
+    //把auto-cork攒下的数据写出去，由loop在本轮循环末尾调用
+    void flushCorked();
     void shutdownInLoop();
+    //还有数据没写完：关注可写事件、挂上写超时、更新loop的待发字节统计
+    void waitForWritable();
+    void reportPendingBytes();
+    //待发送字节数变化后检查高低水位
+    void checkWaterMarks(size_t pending);
+    void releaseLoad();
+    void startReadInLoop();
+    void stopReadInLoop();
+    //按reading_和readPaused_更新channel的读关注
+    void updateReadInterest();
+    void resumeEdgeTriggeredRead();
+    void forceCloseInLoop();
+
+    void handleIdleTimeout();
+    void handleWriteTimeout();
+    void cancelTimeouts();
 
     EventLoop *loop_;
     const std::string name_;
@@ -99,8 +251,44 @@ private:
     HighWaterMarkCallback highWaterMarkCallback_;
 
     CloseCallback closeCallback_;
+    std::shared_ptr<void> context_;
     size_t highWaterMark_;
+    size_t lowWaterMark_;
+    WriteCompleteCallback lowWaterMarkCallback_;
+    //待发送数据超过了高水位、还没降到低水位以下
+    bool aboveHighWaterMark_;
+    bool readBackpressure_;
+    //自动读背压暂停了读
+    bool readPaused_;
 
     Buffer inputBuffer_;
     Buffer outputBuffer_;
+    std::list<OutputSegment> segments_;
+
+    //MSG_ZEROCOPY：每次成功的send内核分配一个递增序号，完成通知按序号区间返回
+    //zeroCopyInflight_记录每个payload最后一次send的序号，完成到这个序号之前payload必须保持有效
+    bool zeroCopy_;
+    size_t zeroCopyThreshold_;
+    uint32_t zeroCopyNextSeq_;
+    std::deque<std::pair<uint32_t, SharedPayload>> zeroCopyInflight_;
+
+    //挂在所属loop的时间轮上：idleEntry_每次读写刷新；writeEntry_在outputBuffer_非空期间有效，写出进展时刷新
+    double idleTimeout_;
+    double writeTimeout_;
+    TimingWheel::Entry idleEntry_;
+    TimingWheel::Entry writeEntry_;
+
+    //下次读之前预留的可写区大小，根据实际读到的字节数自适应
+    size_t readHint_;
+    int smallReads_;
+    //一次可读事件里最多读多少字节，0表示只读一次
+    size_t readBudget_;
+
+    //autoCork_开启时，corked_表示outputBuffer_里有待本轮末尾刷出的数据，且已经向loop登记过
+    bool autoCork_;
+    bool corked_;
+
+    //计入所属loop负载统计的连接数和待发字节数，供EventLoopThreadPool选择loop
+    bool loadCounted_;
+    size_t reportedPendingBytes_;
 };
\ No newline at end of file
@@ -2,8 +2,15 @@
 #include "TcpConnection.h"
 #include "Logger.h"
 #include <string.h>
+#include <future>
 
 
+static void establishConnections(const std::vector<TcpConnectionPtr>& conns){
+    for(const TcpConnectionPtr& conn : conns){
+        conn->connectionEstablished();
+    }
+}
+
 static EventLoop* CheckLoopNotNull(EventLoop *loop)
 {
     if (loop == nullptr)
@@ -24,26 +31,64 @@ static EventLoop* CheckLoopNotNull(EventLoop *loop)
  * 析构函数：主动关闭。即server析构的时候，disable Channel，删除channel
  * 
  * TcpServer的start：1. 启动线程池   2.在main loop 中启动listen
+ *          按loop accept的模式下，每个loop有自己的Acceptor，在自己的线程里listen、accept、建立连接，不再经过main loop转交，
+ *          connections_会被多个loop线程同时增删，用connectionsMutex_保护
+ *          单个Acceptor时，一次可读事件accept的一批连接先按subLoop分组，每个subLoop只投递一个任务、唤醒一次
 */
 
 
 TcpServer::TcpServer(EventLoop *loop, const InetAddress& listenAddr, 
         const std::string& name, Option option)
         :loop_(CheckLoopNotNull(loop)), 
-        acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)), 
         ipPort_(listenAddr.toIpPort()), 
         name_(name),
+        listenAddr_(listenAddr),
+        acceptor_(new Acceptor(loop, listenAddr, option == kReusePort)), 
+        acceptMode_(kSingleAcceptor),
+        acceptBatch_(Acceptor::kDefaultAcceptBatch),
         threadPool_(new EventLoopThreadPool(loop, name)),
         connectionCallback_(),
         messageCallback_(),
+        idleTimeout_(0.0),
+        writeTimeout_(0.0),
+        chainedOutputBuffer_(false),
+        readBudget_(0),
+        autoCork_(false),
+        edgeTriggered_(false),
+        highWaterMark_(64 * 1024 * 1024),
+        lowWaterMark_(0),
+        readBackpressure_(false),
         nextConnId(1),
         started_(0)
         {
 
         acceptor_->setNewConnectionCallback(std::bind(&TcpServer::newConnection, this, std::placeholders::_1, std::placeholders::_2));
+    acceptor_->setBatchDoneCallback(std::bind(&TcpServer::handoffConnections, this));
 }
 
 TcpServer::~TcpServer(){
+    //每个loop的Acceptor要在自己的loop线程里从poller删除。它的回调绑定了this，
+    //必须等所有loop都删完再返回，否则析构之后那个loop上accept的连接会调用已经释放的TcpServer
+    std::vector<std::promise<void>> destroyed(loopAcceptors_.size());
+    std::vector<std::future<void>> waits;
+    for(size_t i = 0; i < loopAcceptors_.size(); ++i){
+        Acceptor* owned = loopAcceptors_[i].release();
+        EventLoop* ownerLoop = owned->ownerLoop();
+        if(ownerLoop->isInLoopThread()){
+            delete owned;
+            continue;
+        }
+        std::promise<void>* done = &destroyed[i];
+        waits.push_back(done->get_future());
+        ownerLoop->queueInLoop([owned, done](){
+            delete owned;
+            done->set_value();
+        });
+    }
+    for(std::future<void>& wait : waits){
+        wait.wait();
+    }
+    std::unique_lock<std::mutex> lock(connectionsMutex_);
     for(auto item : connections_){
         TcpConnectionPtr conn(item.second);
         item.second.reset();
@@ -57,19 +102,51 @@ void TcpServer::setThreadNum(int numThreads){
     threadPool_->setThreadNum(numThreads);
 }
 
+void TcpServer::setLoadBalance(EventLoopThreadPool::LoadBalance policy){
+    threadPool_->setLoadBalance(policy);
+}
+
+void TcpServer::setBusyPoll(int spinUs, int socketBusyPollUs){
+    threadPool_->setBusyPoll(spinUs, socketBusyPollUs);
+}
+
+void TcpServer::setCpuAffinity(const std::vector<std::vector<int>>& cpuSets, bool bindNuma){
+    threadPool_->setCpuAffinity(cpuSets, bindNuma);
+}
+
 void TcpServer::start(){
     if(started_++ == 0){
         threadPool_->start(threadInitCallback_);
-        loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+        if(acceptMode_ == kSingleAcceptor){
+            acceptor_->setAcceptBatch(acceptBatch_);
+            loop_->runInLoop(std::bind(&Acceptor::listen, acceptor_.get()));
+            return;
+        }
+        //构造时绑定的socket没有SO_REUSEPORT，先释放端口，每个loop重新绑定
+        if(acceptMode_ == kReusePortPerLoop){
+            acceptor_.reset();
+        }
+        for(EventLoop* ioLoop : threadPool_->getAllLoops()){
+            Acceptor* acceptor = (acceptMode_ == kReusePortPerLoop)
+                ? new Acceptor(ioLoop, listenAddr_, true)
+                : new Acceptor(ioLoop, *acceptor_);
+            acceptor->setNewConnectionCallback(std::bind(&TcpServer::establishConnection, this, ioLoop,
+                std::placeholders::_1, std::placeholders::_2));
+            acceptor->setAcceptBatch(acceptBatch_);
+            loopAcceptors_.emplace_back(acceptor);
+            ioLoop->runInLoop(std::bind(&Acceptor::listen, acceptor));
+        }
     }
 }
 
 
 void TcpServer::newConnection(int sockFd, const InetAddress& peerAddress){
-    EventLoop *ioLoop = threadPool_->getNextLoop();
+    establishConnection(threadPool_->getNextLoop(peerAddress), sockFd, peerAddress);
+}
+
+void TcpServer::establishConnection(EventLoop* ioLoop, int sockFd, const InetAddress& peerAddress){
     char buf[64] = {0};
-    snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId);
-    ++nextConnId;
+    snprintf(buf, sizeof buf, "-%s#%d", ipPort_.c_str(), nextConnId++);
     std::string connName = name_ + buf;
 
     LOG_INFO("TcpServer::newConnection [%s] - new connection [%s] from %s",
@@ -88,25 +165,61 @@ void TcpServer::newConnection(int sockFd, const InetAddress& peerAddress){
         sockFd,
         localAddr,
         peerAddress));
-    connections_[connName] = conn;
+    {
+        std::unique_lock<std::mutex> lock(connectionsMutex_);
+        connections_[connName] = conn;
+    }
     conn->setConnectionCallback(connectionCallback_);
     conn->setMessageCallback(messageCallback_);
     conn->setWriteCompleleCallback(writeCompleteCallback_);
+    conn->setIdleTimeout(idleTimeout_);
+    conn->setWriteTimeout(writeTimeout_);
+    conn->outputBuffer()->setChained(chainedOutputBuffer_);
+    conn->setReadBudget(readBudget_);
+    conn->setAutoCork(autoCork_);
+    conn->setEdgeTriggered(edgeTriggered_);
+    conn->setHighWaterMarkCallback(highWaterMarkCallback_);
+    conn->setLowWaterMarkCallback(lowWaterMarkCallback_);
+    conn->setWaterMarks(highWaterMark_, lowWaterMark_);
+    conn->setReadBackpressure(readBackpressure_);
 
     conn->setCloseCallback(
         std::bind(&TcpServer::removeConnection, this, std::placeholders::_1)
     );
-    ioLoop->runInLoop(std::bind(&TcpConnection::connectionEstablished, conn));
+    if(ioLoop->isInLoopThread()){
+        conn->connectionEstablished();
+    }else{
+        pendingConnections_[ioLoop].push_back(conn);
+    }
+}
+
+void TcpServer::handoffConnections(){
+    for(auto& item : pendingConnections_){
+        if(item.second.empty()){
+            continue;
+        }
+        std::vector<TcpConnectionPtr> conns;
+        conns.swap(item.second);
+        item.first->queueInLoop(std::bind(&establishConnections, std::move(conns)));
+    }
 }
 
 void TcpServer::removeConnection(const TcpConnectionPtr& conn){
-    loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop, this, conn));
+    if(acceptMode_ == kSingleAcceptor){
+        loop_->runInLoop(std::bind(&TcpServer::removeConnectionInLoop, this, conn));
+    }else{
+        //连接是在它自己的loop里建立的，也就地删除
+        removeConnectionInLoop(conn);
+    }
 }
 
 void TcpServer::removeConnectionInLoop(const TcpConnectionPtr& conn){
     LOG_INFO("TcpServer::removeConnectionInLoop [%s] - connection %s\n", 
         name_.c_str(), conn->name().c_str());
-    connections_.erase(conn->name());
+    {
+        std::unique_lock<std::mutex> lock(connectionsMutex_);
+        connections_.erase(conn->name());
+    }
     EventLoop *ioLoop = conn->getLoop();
     ioLoop->queueInLoop(
         std::bind(&TcpConnection::connectionDestroyed, conn)
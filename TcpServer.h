@@ -3,6 +3,8 @@
 #include <atomic>
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include <mutex>
 
 #include "Callbacks.h"
 #include "EventLoop.h"
@@ -20,6 +22,15 @@ public:
         kReusePort
     };
 
+    //kSingleAcceptor：baseLoop上一个Acceptor，accept后轮询交给subLoop
+    //kReusePortPerLoop：每个loop一个SO_REUSEPORT的监听socket，内核分发连接，在哪个loop accept就在哪个loop上服务
+    //kExclusivePerLoop：所有loop以EPOLLEXCLUSIVE监听同一个socket，同样是谁accept谁服务
+    enum AcceptMode{
+        kSingleAcceptor,
+        kReusePortPerLoop,
+        kExclusivePerLoop
+    };
+
     TcpServer(EventLoop *loop, const InetAddress& listenAddr, const std::string& name, Option option = kNonReusePort);
     ~TcpServer();
 
@@ -27,13 +38,56 @@ public:
     void setConnectionCallback(const ConnectionCallback &cb) { connectionCallback_ = cb; }
     void setMessageCallback(const MessageCallback &cb) { messageCallback_ = cb; }
     void setWriteCompleteCallback(const WriteCompleteCallback &cb) { writeCompleteCallback_ = cb; }
+    void setHighWaterMarkCallback(const HighWaterMarkCallback &cb) { highWaterMarkCallback_ = cb; }
+    void setLowWaterMarkCallback(const WriteCompleteCallback &cb) { lowWaterMarkCallback_ = cb; }
+
+    //连接待发送数据的高低水位，见TcpConnection::setWaterMarks
+    void setWaterMarks(size_t high, size_t low) { highWaterMark_ = high; lowWaterMark_ = low; }
+
+    //待发送数据超过高水位时停止读这个连接，降到低水位以下恢复，限制慢客户端占用的内存
+    void setReadBackpressure(bool on) { readBackpressure_ = on; }
 
     void setThreadNum(int numThreads);
 
+    //单个Acceptor时新连接分给subLoop的策略，必须在start之前设置；按loop accept的模式下连接留在accept它的loop
+    void setLoadBalance(EventLoopThreadPool::LoadBalance policy);
+
+    //subLoop的忙轮询策略，见EventLoopThreadPool::setBusyPoll，必须在start之前设置
+    void setBusyPoll(int spinUs, int socketBusyPollUs = 0);
+
+    //subLoop线程绑核，见EventLoopThreadPool::setCpuAffinity，必须在start之前设置
+    void setCpuAffinity(const std::vector<std::vector<int>>& cpuSets, bool bindNuma = true);
+
+    //单位秒，0表示不启用。空闲超时：无读写则关闭连接；写超时：outputBuffer_积压且长时间写不出去则强制关闭
+    void setIdleTimeout(double seconds) { idleTimeout_ = seconds; }
+    void setWriteTimeout(double seconds) { writeTimeout_ = seconds; }
+
+    //连接的outputBuffer_使用slab链模式：大响应和多次小send不再搬动数据，handleWrite一次writev发出
+    void setChainedOutputBuffer(bool on) { chainedOutputBuffer_ = on; }
+
+    //每次可读事件循环读到读空为止，最多读budget字节，0表示只读一次
+    void setReadBudget(size_t budget) { readBudget_ = budget; }
+
+    //一轮事件循环里对同一连接的多次send合并成一次写，适合一个请求回多次send或流水线请求
+    void setAutoCork(bool on) { autoCork_ = on; }
+
+    //连接的channel使用EPOLLET，读写做到EAGAIN为止，不再为开关EPOLLOUT调用epoll_ctl
+    void setEdgeTriggered(bool on) { edgeTriggered_ = on; }
+
+    //必须在start之前设置
+    void setAcceptMode(AcceptMode mode) { acceptMode_ = mode; }
+
+    //一次可读事件最多accept多少个连接，必须在start之前设置
+    void setAcceptBatch(int batch) { acceptBatch_ = batch; }
+
     void start();
 
 private:
     void newConnection(int sockFd, const InetAddress& peerAddress);
+    //在ioLoop线程或baseLoop线程调用，建立连接并交给ioLoop
+    void establishConnection(EventLoop* ioLoop, int sockFd, const InetAddress& peerAddress);
+    //一批accept结束后，把攒下的连接按subLoop各投递一次
+    void handoffConnections();
     void removeConnection(const TcpConnectionPtr& conn);
     void removeConnectionInLoop(const TcpConnectionPtr& conn);
 
@@ -44,17 +98,38 @@ private:
     const std::string ipPort_;
     const std::string name_;
 
+    const InetAddress listenAddr_;
     std::unique_ptr<Acceptor> acceptor_;
+    //每个loop自己的Acceptor，只在它所属的loop线程里listen和析构
+    std::vector<std::unique_ptr<Acceptor>> loopAcceptors_;
+    AcceptMode acceptMode_;
+    int acceptBatch_;
+    //baseLoop accept的、等待交给各subLoop的连接，只在baseLoop线程访问
+    std::unordered_map<EventLoop*, std::vector<TcpConnectionPtr>> pendingConnections_;
     std::shared_ptr<EventLoopThreadPool> threadPool_;
 
     ConnectionCallback connectionCallback_;
     MessageCallback messageCallback_;
     WriteCompleteCallback writeCompleteCallback_;
+    HighWaterMarkCallback highWaterMarkCallback_;
+    WriteCompleteCallback lowWaterMarkCallback_;
 
     ThreadInitCallback threadInitCallback_;
     
     std::atomic_int started_;
 
-    int nextConnId;
+    double idleTimeout_;
+    double writeTimeout_;
+    bool chainedOutputBuffer_;
+    size_t readBudget_;
+    bool autoCork_;
+    bool edgeTriggered_;
+    size_t highWaterMark_;
+    size_t lowWaterMark_;
+    bool readBackpressure_;
+
+    std::atomic_int nextConnId;
+    //每个loop自己accept时，多个loop线程会同时增删连接
+    std::mutex connectionsMutex_;
     ConnectionMap connections_;
 };
\ No newline at end of file
@@ -43,7 +43,7 @@ void Thread::setDefaultName(){
 void Thread::start(){
     started_ = true;
     sem_t sem;
-    sem_init(&sem, 0, 1);
+    sem_init(&sem, 0, 0);
 
     //pv操作，保证线程创建完成，tid设置正确后，start函数才返回
     thread_ = std::shared_ptr<std::thread>( new std::thread( [&](){
@@ -53,6 +53,7 @@ void Thread::start(){
     } ));
 
     sem_wait(&sem);
+    sem_destroy(&sem);
 }
 
 void Thread::join(){
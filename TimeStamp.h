@@ -11,9 +11,41 @@ public:
     explicit TimeStamp(uint64_t microSecondsSinceEpochArg);
 
     static TimeStamp now();
+    static TimeStamp invalid(){
+        return TimeStamp();
+    }
     std::string toString() const;
 
+    bool valid() const{
+        return microSecondsSinceEpoch_ > 0;
+    }
+
+    uint64_t microSecondsSinceEpoch() const{
+        return microSecondsSinceEpoch_;
+    }
+
+    static const int kMicroSecondsPerSecond = 1000 * 1000;
+
 private:
     uint64_t microSecondsSinceEpoch_;
 
-};
\ No newline at end of file
+};
+
+inline bool operator<(TimeStamp lhs, TimeStamp rhs){
+    return lhs.microSecondsSinceEpoch() < rhs.microSecondsSinceEpoch();
+}
+
+inline bool operator==(TimeStamp lhs, TimeStamp rhs){
+    return lhs.microSecondsSinceEpoch() == rhs.microSecondsSinceEpoch();
+}
+
+//返回 high - low 的秒数
+inline double timeDifference(TimeStamp high, TimeStamp low){
+    int64_t diff = static_cast<int64_t>(high.microSecondsSinceEpoch() - low.microSecondsSinceEpoch());
+    return static_cast<double>(diff) / TimeStamp::kMicroSecondsPerSecond;
+}
+
+inline TimeStamp addTime(TimeStamp timestamp, double seconds){
+    int64_t delta = static_cast<int64_t>(seconds * TimeStamp::kMicroSecondsPerSecond);
+    return TimeStamp(timestamp.microSecondsSinceEpoch() + delta);
+}
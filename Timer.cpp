@@ -0,0 +1,17 @@
+#include "Timer.h"
+
+/**
+ * Timer：一个定时任务。维护了到期时间expiration_、重复间隔interval_、用户回调callback_
+ * sequence_：全局递增的序号，和Timer*一起组成TimerId。Timer被delete后地址可能被复用，靠序号区分新旧定时器
+ * restart：重复定时器到期后，由TimerQueue调用，把到期时间推到 now + interval
+*/
+
+std::atomic<int64_t> Timer::s_numCreated_(0);
+
+void Timer::restart(TimeStamp now){
+    if(repeat_){
+        expiration_ = addTime(now, interval_);
+    }else{
+        expiration_ = TimeStamp::invalid();
+    }
+}
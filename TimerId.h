@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdint.h>
+
+class Timer;
+
+/**
+ * 用户持有的定时器句柄，只用于cancel。可拷贝，不拥有Timer
+*/
+class TimerId{
+public:
+    TimerId() : timer_(nullptr), sequence_(0){}
+
+    TimerId(Timer* timer, int64_t seq) : timer_(timer), sequence_(seq){}
+
+    friend class TimerQueue;
+
+private:
+    Timer* timer_;
+    int64_t sequence_;
+};
@@ -0,0 +1,179 @@
+#include "TimerQueue.h"
+#include "Timer.h"
+#include "TimerId.h"
+#include "EventLoop.h"
+#include "Logger.h"
+
+#include <sys/timerfd.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ * TimerQueue：每个EventLoop持有一个，由一个timerfd驱动
+ * 维护了一个timerfd和它的Channel，Channel的读回调是handleRead，注册在所属loop的poller上，和普通连接一样被epoll_wait返回
+ * timers_：set<pair<到期时间, Timer*>>，按到期时间排序，begin()就是最早到期的定时器。timerfd总是被设置为timers_.begin()的到期时间
+ * activeTimers_：set<pair<Timer*, sequence>>，和timers_是同一批Timer，用于cancel时快速查找
+ * 
+ * addTimer：任意线程都可以调用，new一个Timer后runInLoop到所属线程插入，不需要加锁
+ * cancel：任意线程都可以调用，runInLoop到所属线程。若在activeTimers_里找到，则从两个set里删除并立刻delete；
+ *         若找不到且正在执行到期回调，说明是在回调里cancel自己（或同批到期的定时器），记入cancelingTimers_，reset时不再restart
+ * handleRead：读timerfd，取出所有到期定时器，执行回调，重复定时器重新插入，其余delete，最后按新的最早到期时间重设timerfd
+*/
+
+namespace{
+
+int createTimerfd(){
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(timerfd < 0){
+        LOG_FATAL("timerfd_create err, errno: %d\n", errno);
+    }
+    return timerfd;
+}
+
+struct timespec howMuchTimeFromNow(TimeStamp when){
+    int64_t microseconds = static_cast<int64_t>(when.microSecondsSinceEpoch())
+        - static_cast<int64_t>(TimeStamp::now().microSecondsSinceEpoch());
+    if(microseconds < 100){
+        microseconds = 100;
+    }
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(microseconds / TimeStamp::kMicroSecondsPerSecond);
+    ts.tv_nsec = static_cast<long>((microseconds % TimeStamp::kMicroSecondsPerSecond) * 1000);
+    return ts;
+}
+
+void readTimerfd(int timerfd){
+    uint64_t howmany;
+    ssize_t n = ::read(timerfd, &howmany, sizeof howmany);
+    if(n != sizeof howmany){
+        LOG_ERROR("TimerQueue::handleRead() read %ld bytes instead of 8", n);
+    }
+}
+
+void resetTimerfd(int timerfd, TimeStamp expiration){
+    struct itimerspec newValue;
+    memset(&newValue, 0, sizeof newValue);
+    newValue.it_value = howMuchTimeFromNow(expiration);
+    if(::timerfd_settime(timerfd, 0, &newValue, nullptr) < 0){
+        LOG_ERROR("timerfd_settime err, errno: %d", errno);
+    }
+}
+
+}
+
+TimerQueue::TimerQueue(EventLoop* loop)
+    : loop_(loop), timerfd_(createTimerfd()), timerfdChannel_(loop, timerfd_),
+    timers_(), callingExpiredTimers_(false){
+
+    timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue(){
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+    for(const Entry& timer : timers_){
+        delete timer.second;
+    }
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, TimeStamp when, double interval){
+    Timer* timer = new Timer(std::move(cb), when, interval);
+    loop_->runInLoop(std::bind(&TimerQueue::addTimerInLoop, this, timer));
+    return TimerId(timer, timer->sequence());
+}
+
+void TimerQueue::cancel(TimerId timerId){
+    loop_->runInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+}
+
+int TimerQueue::nextTimeoutMs(int defaultMs) const{
+    if(timers_.empty()){
+        return defaultMs;
+    }
+    int64_t microseconds = static_cast<int64_t>(timers_.begin()->first.microSecondsSinceEpoch())
+        - static_cast<int64_t>(TimeStamp::now().microSecondsSinceEpoch());
+    if(microseconds <= 0){
+        return 0;
+    }
+    //向上取整，避免epoll_wait比timerfd先超时而空转一轮
+    int64_t ms = (microseconds + 999) / 1000;
+    return ms < defaultMs ? static_cast<int>(ms) : defaultMs;
+}
+
+void TimerQueue::addTimerInLoop(Timer* timer){
+    bool earliestChanged = insert(timer);
+    if(earliestChanged){
+        resetTimerfd(timerfd_, timer->expiration());
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId){
+    ActiveTimer timer(timerId.timer_, timerId.sequence_);
+    ActiveTimerSet::iterator it = activeTimers_.find(timer);
+    if(it != activeTimers_.end()){
+        timers_.erase(Entry(it->first->expiration(), it->first));
+        delete it->first;
+        activeTimers_.erase(it);
+    }else if(callingExpiredTimers_){
+        cancelingTimers_.insert(timer);
+    }
+}
+
+void TimerQueue::handleRead(){
+    TimeStamp now(TimeStamp::now());
+    readTimerfd(timerfd_);
+
+    std::vector<Entry> expired = getExpired(now);
+
+    callingExpiredTimers_ = true;
+    cancelingTimers_.clear();
+    for(const Entry& it : expired){
+        it.second->run();
+    }
+    callingExpiredTimers_ = false;
+
+    reset(expired, now);
+}
+
+std::vector<TimerQueue::Entry> TimerQueue::getExpired(TimeStamp now){
+    std::vector<Entry> expired;
+    Entry sentry(now, reinterpret_cast<Timer*>(UINTPTR_MAX));
+    TimerList::iterator end = timers_.lower_bound(sentry);
+    std::copy(timers_.begin(), end, back_inserter(expired));
+    timers_.erase(timers_.begin(), end);
+
+    for(const Entry& it : expired){
+        activeTimers_.erase(ActiveTimer(it.second, it.second->sequence()));
+    }
+    return expired;
+}
+
+void TimerQueue::reset(const std::vector<Entry>& expired, TimeStamp now){
+    for(const Entry& it : expired){
+        ActiveTimer timer(it.second, it.second->sequence());
+        if(it.second->repeat() && cancelingTimers_.find(timer) == cancelingTimers_.end()){
+            it.second->restart(now);
+            insert(it.second);
+        }else{
+            delete it.second;
+        }
+    }
+
+    if(!timers_.empty()){
+        resetTimerfd(timerfd_, timers_.begin()->second->expiration());
+    }
+}
+
+bool TimerQueue::insert(Timer* timer){
+    bool earliestChanged = false;
+    TimeStamp when = timer->expiration();
+    TimerList::iterator it = timers_.begin();
+    if(it == timers_.end() || when < it->first){
+        earliestChanged = true;
+    }
+    timers_.insert(Entry(when, timer));
+    activeTimers_.insert(ActiveTimer(timer, timer->sequence()));
+    return earliestChanged;
+}
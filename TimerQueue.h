@@ -0,0 +1,57 @@
+#pragma once
+
+#include <set>
+#include <vector>
+#include <utility>
+
+#include "noncopyable.h"
+#include "TimeStamp.h"
+#include "Callbacks.h"
+#include "Channel.h"
+
+class EventLoop;
+class Timer;
+class TimerId;
+
+class TimerQueue : noncopyable{
+public:
+    explicit TimerQueue(EventLoop* loop);
+    ~TimerQueue();
+
+    //线程安全，可以在任意线程调用
+    TimerId addTimer(TimerCallback cb, TimeStamp when, double interval);
+
+    void cancel(TimerId timerId);
+
+    //距离最近一个定时器到期还有多少毫秒，没有定时器时返回defaultMs
+    int nextTimeoutMs(int defaultMs) const;
+
+private:
+    using Entry = std::pair<TimeStamp, Timer*>;
+    using TimerList = std::set<Entry>;
+    using ActiveTimer = std::pair<Timer*, int64_t>;
+    using ActiveTimerSet = std::set<ActiveTimer>;
+
+    void addTimerInLoop(Timer* timer);
+    void cancelInLoop(TimerId timerId);
+
+    void handleRead();
+
+    std::vector<Entry> getExpired(TimeStamp now);
+    void reset(const std::vector<Entry>& expired, TimeStamp now);
+
+    bool insert(Timer* timer);
+
+    EventLoop* loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+
+    //按到期时间排序
+    TimerList timers_;
+
+    //按Timer*排序，用于cancel时查找。和timers_保存同一批Timer
+    ActiveTimerSet activeTimers_;
+    bool callingExpiredTimers_;
+    //正在执行到期回调时被cancel的重复定时器，回调执行完后不再restart
+    ActiveTimerSet cancelingTimers_;
+};
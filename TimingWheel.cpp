@@ -0,0 +1,87 @@
+#include "TimingWheel.h"
+#include "EventLoop.h"
+
+/**
+ * TimingWheel：哈希时间轮。buckets_[i]是第i个槽，每个槽是一个以哨兵节点为头的环形双向链表
+ * 由loop的runEvery每tickSeconds_驱动一次onTick，currentTick_递增，处理 currentTick_ % 槽数 这个槽
+ * 
+ * schedule：entry不在轮上时，计算到期tick，挂到对应槽上；
+ *          entry已在轮上时（连接的每次读写都会走这里），只改写deadline_，不动链表。真正的移动推迟到它所在的槽被扫描时
+ * onTick：扫描当前槽，deadline_已到的摘下并执行回调；没到的挪到 deadline_ % 槽数 的槽上。
+ *          超过一圈的超时会在同一个槽里多待几圈，相当于单层时间轮 + 圈数，摊还仍是O(1)
+*/
+
+TimingWheel::TimingWheel(EventLoop* loop, double tickSeconds, int numBuckets)
+    : loop_(loop), tickSeconds_(tickSeconds), currentTick_(0), size_(0), buckets_(numBuckets){
+    for(Entry& head : buckets_){
+        head.prev_ = head.next_ = &head;
+    }
+    tickTimer_ = loop_->runEvery(tickSeconds_, std::bind(&TimingWheel::onTick, this));
+}
+
+TimingWheel::~TimingWheel(){
+    loop_->cancel(tickTimer_);
+    for(Entry& head : buckets_){
+        while(head.next_ != &head){
+            unlink(head.next_);
+        }
+    }
+}
+
+void TimingWheel::schedule(Entry* entry, double timeout){
+    uint64_t ticks = static_cast<uint64_t>(timeout / tickSeconds_) + 1;
+    entry->deadline_ = currentTick_ + ticks;
+    if(!entry->scheduled()){
+        link(&buckets_[entry->deadline_ % buckets_.size()], entry);
+        ++size_;
+    }
+}
+
+void TimingWheel::cancel(Entry* entry){
+    if(entry->scheduled()){
+        unlink(entry);
+        --size_;
+    }
+}
+
+void TimingWheel::onTick(){
+    ++currentTick_;
+    Entry* head = &buckets_[currentTick_ % buckets_.size()];
+
+    //先把整条链摘到临时哨兵上，回调里再schedule/cancel别的entry也不会影响本次遍历
+    Entry pending;
+    pending.prev_ = pending.next_ = &pending;
+    if(head->next_ != head){
+        pending.next_ = head->next_;
+        pending.prev_ = head->prev_;
+        pending.next_->prev_ = &pending;
+        pending.prev_->next_ = &pending;
+        head->prev_ = head->next_ = head;
+    }
+
+    while(pending.next_ != &pending){
+        Entry* entry = pending.next_;
+        unlink(entry);
+        if(entry->deadline_ <= currentTick_){
+            --size_;
+            if(entry->callback_){
+                entry->callback_();
+            }
+        }else{
+            link(&buckets_[entry->deadline_ % buckets_.size()], entry);
+        }
+    }
+}
+
+void TimingWheel::link(Entry* head, Entry* entry){
+    entry->prev_ = head->prev_;
+    entry->next_ = head;
+    head->prev_->next_ = entry;
+    head->prev_ = entry;
+}
+
+void TimingWheel::unlink(Entry* entry){
+    entry->prev_->next_ = entry->next_;
+    entry->next_->prev_ = entry->prev_;
+    entry->prev_ = entry->next_ = nullptr;
+}
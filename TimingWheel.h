@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "noncopyable.h"
+#include "TimerId.h"
+
+class EventLoop;
+
+/**
+ * 每个EventLoop一个的哈希时间轮，用于大量连接的空闲超时/写超时
+ * Entry是侵入式的链表节点，嵌在使用者（TcpConnection）内部，schedule/cancel都是O(1)且不分配内存
+ * 只能在所属loop线程调用
+*/
+class TimingWheel : noncopyable{
+public:
+    using ExpireCallback = std::function<void()>;
+
+    class Entry : noncopyable{
+    public:
+        Entry() : prev_(nullptr), next_(nullptr), deadline_(0){}
+
+        void setExpireCallback(ExpireCallback cb){
+            callback_ = std::move(cb);
+        }
+
+        bool scheduled() const{
+            return next_ != nullptr;
+        }
+
+    private:
+        friend class TimingWheel;
+        Entry* prev_;
+        Entry* next_;
+        uint64_t deadline_;
+        ExpireCallback callback_;
+    };
+
+    static const int kDefaultBuckets = 512;
+
+    TimingWheel(EventLoop* loop, double tickSeconds = 1.0, int numBuckets = kDefaultBuckets);
+    ~TimingWheel();
+
+    //timeout秒后到期。已经在轮上的entry只更新到期时间，不移动节点
+    void schedule(Entry* entry, double timeout);
+    void cancel(Entry* entry);
+
+    size_t size() const{
+        return size_;
+    }
+
+private:
+    void onTick();
+
+    static void link(Entry* head, Entry* entry);
+    static void unlink(Entry* entry);
+
+    EventLoop* loop_;
+    const double tickSeconds_;
+    uint64_t currentTick_;
+    size_t size_;
+    //每个桶是一个带哨兵的环形双向链表
+    std::vector<Entry> buckets_;
+    TimerId tickTimer_;
+};
@@ -0,0 +1,141 @@
+//Acceptor：一次可读事件最多accept acceptBatch_个连接，每批结束回调一次；
+//fd耗尽(EMFILE)时用预留的空闲fd把连接接下来关掉，监听fd不会一直可读导致loop空转
+#include "Acceptor.h"
+#include "InetAddress.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+
+namespace{
+
+void testBatches(){
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    Acceptor acceptor(&loop, InetAddress(port), false);
+    acceptor.setAcceptBatch(4);
+
+    std::vector<int> accepted;
+    std::vector<int> batches;
+    int inBatch = 0;
+    acceptor.setNewConnectionCallback([&](int sockfd, const InetAddress&){
+        accepted.push_back(sockfd);
+        ++inBatch;
+    });
+    acceptor.setBatchDoneCallback([&](){
+        batches.push_back(inBatch);
+        inBatch = 0;
+        if(accepted.size() == 10){
+            loop.quit();
+        }
+    });
+    acceptor.listen();
+
+    //loop开始之前全部连上，都在backlog里等着
+    std::vector<int> clients;
+    for(int i = 0; i < 10; ++i){
+        clients.push_back(testutil::connectTo(port));
+        CHECK(clients.back() >= 0);
+    }
+    loop.loop();
+
+    CHECK((batches == std::vector<int>{4, 4, 2}));
+    for(int fd : accepted){
+        ::close(fd);
+    }
+    for(int fd : clients){
+        ::close(fd);
+    }
+}
+
+bool peerClosed(int fd){
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    char c;
+    return ::poll(&pfd, 1, 1000) == 1 && ::read(fd, &c, 1) == 0;
+}
+
+void testEmfile(){
+    const int kClients = 5;
+    const int kFreeFds = 2;
+
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    Acceptor acceptor(&loop, InetAddress(port), false);
+    std::vector<int> accepted;
+    int handleReads = 0;
+    acceptor.setNewConnectionCallback([&accepted](int sockfd, const InetAddress&){
+        accepted.push_back(sockfd);
+    });
+    acceptor.setBatchDoneCallback([&handleReads](){
+        ++handleReads;
+    });
+    acceptor.listen();
+
+    std::vector<int> clients;
+    for(int i = 0; i < kClients; ++i){
+        clients.push_back(testutil::connectTo(port));
+        CHECK(clients.back() >= 0);
+    }
+
+    //把fd上限压低，占满剩下的位置，只留kFreeFds个空位给accept
+    struct rlimit old;
+    CHECK(::getrlimit(RLIMIT_NOFILE, &old) == 0);
+    int maxFd = ::fcntl(0, F_DUPFD, 0);
+    CHECK(maxFd >= 0);
+    ::close(maxFd);
+    for(int fd : clients){
+        maxFd = std::max(maxFd, fd);
+    }
+    struct rlimit low = old;
+    low.rlim_cur = maxFd + 16;
+    CHECK(::setrlimit(RLIMIT_NOFILE, &low) == 0);
+    std::vector<int> fillers;
+    int fd;
+    while((fd = ::open("/dev/null", O_RDONLY)) >= 0){
+        fillers.push_back(fd);
+    }
+    CHECK(errno == EMFILE);
+    for(int i = 0; i < kFreeFds; ++i){
+        ::close(fillers.back());
+        fillers.pop_back();
+    }
+
+    loop.runAfter(0.1, [&loop](){ loop.quit(); });
+    loop.loop();
+
+    CHECK(static_cast<int>(accepted.size()) == kFreeFds);
+    //fd满了之后的连接被接下来立即关闭，而不是一直留在backlog里让监听fd保持可读
+    CHECK(handleReads < 20);
+
+    for(int fd : fillers){
+        ::close(fd);
+    }
+    CHECK(::setrlimit(RLIMIT_NOFILE, &old) == 0);
+    int closedByServer = 0;
+    for(int fd : clients){
+        if(peerClosed(fd)){
+            ++closedByServer;
+        }
+        ::close(fd);
+    }
+    CHECK(closedByServer == kClients - kFreeFds);
+    for(int fd : accepted){
+        ::close(fd);
+    }
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(FATAL);
+    testBatches();
+    testEmfile();
+    printf("Acceptor_test OK\n");
+    return 0;
+}
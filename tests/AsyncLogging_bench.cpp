@@ -0,0 +1,86 @@
+//AsyncLogging前台append的延迟：1/2/4/8个线程同时写，统计每次append的耗时分布、总吞吐和丢弃的条数
+//用法：AsyncLogging_bench [每线程条数=200000] [每条字节数=100]
+#include "AsyncLogging.h"
+#include "BenchUtil.h"
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace{
+
+void removeDir(const std::string& dir){
+    DIR* d = ::opendir(dir.c_str());
+    if(d == nullptr){
+        return;
+    }
+    while(dirent* e = ::readdir(d)){
+        std::string name(e->d_name);
+        if(name != "." && name != ".."){
+            ::unlink((dir + "/" + name).c_str());
+        }
+    }
+    ::closedir(d);
+    ::rmdir(dir.c_str());
+}
+
+void run(const std::string& dir, int threads, long lines, size_t lineSize){
+    AsyncLogging log(dir + "/bench", 1024 * 1024 * 1024);
+    log.start();
+
+    std::vector<std::vector<int64_t>> samples(threads);
+    std::vector<std::thread> workers;
+    int64_t start = benchutil::nowNs();
+    for(int t = 0; t < threads; ++t){
+        workers.emplace_back([&, t](){
+            std::string line(lineSize - 1, 'a' + t);
+            line += '\n';
+            std::vector<int64_t>& mine = samples[t];
+            mine.reserve(lines);
+            for(long i = 0; i < lines; ++i){
+                int64_t before = benchutil::nowNs();
+                log.append(line.data(), line.size());
+                mine.push_back(benchutil::nowNs() - before);
+            }
+        });
+    }
+    for(std::thread& worker : workers){
+        worker.join();
+    }
+    int64_t elapsed = benchutil::nowNs() - start;
+    log.stop();
+
+    std::vector<int64_t> all;
+    for(const std::vector<int64_t>& mine : samples){
+        all.insert(all.end(), mine.begin(), mine.end());
+    }
+    char name[64];
+    snprintf(name, sizeof name, "append threads=%d", threads);
+    benchutil::printLatency(name, &all);
+    double total = static_cast<double>(threads) * lines;
+    printf("%-28s %.0f lines/s, dropped %llu of %.0f\n", "", total * 1e9 / elapsed,
+        static_cast<unsigned long long>(log.droppedLines()), total);
+}
+
+}
+
+int main(int argc, char* argv[]){
+    long lines = benchutil::argOr(argc, argv, 1, 200000);
+    size_t lineSize = static_cast<size_t>(benchutil::argOr(argc, argv, 2, 100));
+    char dir[] = "/tmp/asynclog_bench_XXXXXX";
+    if(::mkdtemp(dir) == nullptr){
+        perror("mkdtemp");
+        return 1;
+    }
+    const int threadCounts[] = {1, 2, 4, 8};
+    for(int threads : threadCounts){
+        run(dir, threads, lines, lineSize);
+        removeDir(dir);
+        ::mkdir(dir, 0700);
+    }
+    removeDir(dir);
+    return 0;
+}
@@ -0,0 +1,154 @@
+//AsyncLogging：多线程写入后stop，文件里每条日志都是完整的一行、每个线程内保持顺序，写进文件的条数 + 丢弃数 = 写入数；
+//丢弃时后台线程会补一行统计。LogFile：超过rollSize在下一秒换新文件
+#include "AsyncLogging.h"
+#include "LogFile.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <algorithm>
+#include <dirent.h>
+#include <stdio.h>
+
+namespace{
+
+const int kThreads = 4;
+const int kLines = 5000;
+
+//dir下以prefix开头的文件，按文件名排序，也就是按滚动的先后
+std::vector<std::string> listFiles(const std::string& dir, const std::string& prefix){
+    std::vector<std::string> files;
+    DIR* d = ::opendir(dir.c_str());
+    CHECK(d != nullptr);
+    while(dirent* e = ::readdir(d)){
+        std::string name(e->d_name);
+        if(name.compare(0, prefix.size(), prefix) == 0){
+            files.push_back(dir + "/" + name);
+        }
+    }
+    ::closedir(d);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::string readAll(const std::vector<std::string>& files){
+    std::string content;
+    for(const std::string& file : files){
+        std::ifstream in(file.c_str());
+        std::stringstream ss;
+        ss << in.rdbuf();
+        content += ss.str();
+    }
+    return content;
+}
+
+void removeAll(const std::vector<std::string>& files){
+    for(const std::string& file : files){
+        ::unlink(file.c_str());
+    }
+}
+
+//每行 "T<线程> <序号> <填充>"，填充让单线程的数据量远超ring容量，容易触发丢弃
+void testLinesIntact(const std::string& dir){
+    AsyncLogging log(dir + "/async", 1024 * 1024 * 1024);
+    log.start();
+    std::vector<std::thread> threads;
+    for(int t = 0; t < kThreads; ++t){
+        threads.emplace_back([&log, t](){
+            std::string padding(t * 300 + 100, 'x');
+            char line[2048];
+            for(int i = 0; i < kLines; ++i){
+                int n = snprintf(line, sizeof line, "T%d %d %s\n", t, i, padding.c_str());
+                log.append(line, n);
+            }
+        });
+    }
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    log.stop();
+
+    std::vector<std::string> files = listFiles(dir, "async.");
+    CHECK(files.size() == 1);
+    std::istringstream in(readAll(files));
+    std::vector<int> last(kThreads, -1);
+    uint64_t lines = 0;
+    bool sawDropReport = false;
+    std::string line;
+    while(std::getline(in, line)){
+        if(line.compare(0, 21, "AsyncLogging dropped ") == 0){
+            sawDropReport = true;
+            continue;
+        }
+        int t = -1;
+        int i = -1;
+        CHECK(sscanf(line.c_str(), "T%d %d", &t, &i) == 2);
+        CHECK(t >= 0 && t < kThreads);
+        CHECK(line.size() == line.find(' ', line.find(' ') + 1) + 1 + static_cast<size_t>(t * 300 + 100));
+        CHECK(i > last[t]);
+        last[t] = i;
+        ++lines;
+    }
+    CHECK(lines + log.droppedLines() == static_cast<uint64_t>(kThreads * kLines));
+    CHECK(sawDropReport == (log.droppedLines() != 0));
+    printf("AsyncLogging: %llu lines written, %llu dropped\n",
+        static_cast<unsigned long long>(lines), static_cast<unsigned long long>(log.droppedLines()));
+    removeAll(files);
+}
+
+//LOG_xxx经setOutput接到AsyncLogging
+void testLoggerOutput(const std::string& dir){
+    {
+        AsyncLogging log(dir + "/logger", 1024 * 1024);
+        log.start();
+        Logger::getInstance().setOutput(std::bind(&AsyncLogging::append, &log, std::placeholders::_1, std::placeholders::_2));
+        LOG_ERROR("async logger line %d", 42);
+        log.stop();
+        Logger::getInstance().setOutput(nullptr);
+    }
+    std::vector<std::string> files = listFiles(dir, "logger.");
+    CHECK(files.size() == 1);
+    CHECK(readAll(files).find("async logger line 42") != std::string::npos);
+    removeAll(files);
+}
+
+//同一秒内不重复滚动，超过rollSize之后的第一次append（已经过了一秒）才换文件
+void testLogFileRoll(const std::string& dir){
+    {
+        LogFile file(dir + "/roll", 100);
+        std::string first(150, 'a');
+        file.append(first.data(), first.size());
+        ::sleep(1);
+        file.append("b\n", 2);
+        file.append("c\n", 2);
+        file.flush();
+    }
+    std::vector<std::string> files = listFiles(dir, "roll.");
+    CHECK(files.size() == 2);
+    CHECK(readAll(files) == std::string(150, 'a') + "b\nc\n");
+    //构造和第一次append恰好跨秒时，换文件发生在b之前
+    std::string second = readAll(std::vector<std::string>(1, files[1]));
+    CHECK(second == "c\n" || second == "b\nc\n");
+    removeAll(files);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    char dir[] = "/tmp/mymuduo_logXXXXXX";
+    CHECK(::mkdtemp(dir) != nullptr);
+
+    testLinesIntact(dir);
+    testLoggerOutput(dir);
+    testLogFileRoll(dir);
+
+    ::rmdir(dir);
+    printf("AsyncLogging_test OK\n");
+    return 0;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+//tests/下各bench程序共用：计时和延迟分布的打印
+
+namespace benchutil{
+
+inline int64_t nowNs(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//命令行第index个参数，没给就用默认值
+inline long argOr(int argc, char* argv[], int index, long defaultValue){
+    return index < argc ? ::atol(argv[index]) : defaultValue;
+}
+
+//打印 p50/p99/p999/max，单位微秒。samples会被排序
+inline void printLatency(const char* name, std::vector<int64_t>* samples){
+    if(samples->empty()){
+        printf("%-28s no samples\n", name);
+        return;
+    }
+    std::sort(samples->begin(), samples->end());
+    auto at = [samples](double q){
+        return (*samples)[std::min(samples->size() - 1, static_cast<size_t>(q * samples->size()))] / 1000.0;
+    };
+    printf("%-28s n=%zu p50=%.2fus p99=%.2fus p999=%.2fus max=%.2fus\n", name, samples->size(),
+        at(0.5), at(0.99), at(0.999), samples->back() / 1000.0);
+}
+
+}
@@ -0,0 +1,130 @@
+//prepend会把readIndex_挪到kCheapPrepend之前，之后append的扩容/搬移不能算错空间；普通、池化、链式三种Buffer各跑一遍。另外检查懒分配Buffer读不到数据时不占存储
+#include "Buffer.h"
+#include "BufferPool.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <string>
+#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+namespace{
+
+std::string pattern(size_t len, char seed){
+    std::string s(len, '\0');
+    for(size_t i = 0; i < len; ++i){
+        s[i] = static_cast<char>(seed + i % 23);
+    }
+    return s;
+}
+
+//prepend吃掉全部预留空间，再append各种长度：刚好装下、需要搬移、需要扩容
+void testPrependThenAppend(Buffer* buf){
+    std::string body = pattern(1024, 'a');
+    buf->append(body.data(), body.size());
+    buf->prepend("HDR!", 4);
+    buf->prepend("LEN:", 4);
+    buf->append("x", 1);
+    std::string expected = "LEN:HDR!" + body + "x";
+    CHECK(buf->readableBytes() == expected.size());
+    CHECK(std::string(buf->peek(), buf->readableBytes()) == expected);
+
+    //读走一部分腾出前面空间，再append一段需要搬移才能放下的数据
+    buf->retrieve(100);
+    expected.erase(0, 100);
+    buf->prepend("P", 1);
+    expected.insert(0, "P");
+    std::string more = pattern(90, 'k');
+    buf->append(more.data(), more.size());
+    expected += more;
+    CHECK(std::string(buf->peek(), buf->readableBytes()) == expected);
+
+    //超过剩余空间，必须扩容
+    std::string big = pattern(64 * 1024, 'A');
+    buf->prepend("Q", 1);
+    expected.insert(0, "Q");
+    buf->append(big.data(), big.size());
+    expected += big;
+    CHECK(buf->readableBytes() == expected.size());
+    CHECK(std::string(buf->peek(), buf->readableBytes()) == expected);
+
+    buf->retrieveAll();
+    CHECK(buf->readableBytes() == 0);
+}
+
+//头部长度比预留的kCheapPrepend还大
+void testLargePrepend(Buffer* buf){
+    std::string body = pattern(300, 'b');
+    std::string header = pattern(Buffer::kCheapPrepend * 3, 'h');
+    buf->append(body.data(), body.size());
+    buf->prepend(header.data(), header.size());
+    buf->append("yz", 2);
+    CHECK(std::string(buf->peek(), buf->readableBytes()) == header + body + "yz");
+    buf->retrieveAll();
+}
+
+//懒分配Buffer读到EAGAIN/EOF时不能向pool要存储，读到数据才按实际大小分配
+void testLazyReadFd(EventLoop* loop){
+    int fds[2];
+    CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    CHECK(::fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+    char extrabuf[4096];
+    int saveErrno = 0;
+    Buffer buf(loop->bufferPool());
+
+    CHECK(buf.readFd(fds[0], &saveErrno, extrabuf, sizeof extrabuf) < 0);
+    CHECK(saveErrno == EAGAIN);
+    CHECK(buf.internalCapacity() == 0);
+    CHECK(loop->bufferPool()->bytesHeld() == 0);
+
+    std::string small = pattern(100, 's');
+    CHECK(::write(fds[1], small.data(), small.size()) == static_cast<ssize_t>(small.size()));
+    CHECK(buf.readFd(fds[0], &saveErrno, extrabuf, sizeof extrabuf) == static_cast<ssize_t>(small.size()));
+    CHECK(buf.retrieveAllAsString() == small);
+    CHECK(buf.internalCapacity() == 0);
+
+    ::close(fds[1]);
+    CHECK(buf.readFd(fds[0], &saveErrno, extrabuf, sizeof extrabuf) == 0);
+    CHECK(buf.internalCapacity() == 0);
+    CHECK(loop->bufferPool()->bytesHeld() == 0);
+    ::close(fds[0]);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    EventLoop loop;
+
+    {
+        Buffer buf;
+        testPrependThenAppend(&buf);
+        testLargePrepend(&buf);
+    }
+    {
+        Buffer buf(loop.bufferPool());
+        testPrependThenAppend(&buf);
+        testLargePrepend(&buf);
+    }
+    {
+        Buffer buf(loop.bufferPool());
+        buf.setChained(true);
+        testPrependThenAppend(&buf);
+        testLargePrepend(&buf);
+    }
+    //prepend到空的懒分配Buffer
+    {
+        Buffer buf(loop.bufferPool());
+        buf.prepend("abc", 3);
+        buf.append("d", 1);
+        CHECK(buf.retrieveAllAsString() == "abcd");
+    }
+
+    testLazyReadFd(&loop);
+
+    printf("Buffer_test OK\n");
+    return 0;
+}
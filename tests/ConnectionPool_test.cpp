@@ -0,0 +1,214 @@
+//客户端一侧：TcpClient连上、收发、disconnect；Connector连不上时按退避重试，次数用完回调失败；
+//ConnectionPool归还的连接再次借出时原样复用，对端关闭的空闲连接被摘掉，空闲数超过上限的直接关闭
+#include "ConnectionPool.h"
+#include "Connector.h"
+#include "TcpClient.h"
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+#include <functional>
+
+namespace{
+
+//在loop线程里执行f并等它返回
+void inLoop(EventLoop* loop, const std::function<void()>& f){
+    std::promise<void> done;
+    loop->runInLoop([&](){
+        f();
+        done.set_value();
+    });
+    done.get_future().wait();
+}
+
+//每10毫秒在loop线程里检查一次，最多等2秒
+bool waitFor(EventLoop* loop, const std::function<bool()>& cond){
+    for(int i = 0; i < 200; ++i){
+        bool ok = false;
+        inLoop(loop, [&](){ ok = cond(); });
+        if(ok){
+            return true;
+        }
+        ::usleep(10 * 1000);
+    }
+    return false;
+}
+
+TcpConnectionPtr acquire(EventLoop* loop, ConnectionPool* pool, const InetAddress& addr){
+    std::promise<TcpConnectionPtr> result;
+    inLoop(loop, [&](){
+        pool->acquire(addr, [&result](const TcpConnectionPtr& conn){ result.set_value(conn); });
+    });
+    return result.get_future().get();
+}
+
+std::string roundTrip(EventLoop* loop, const TcpConnectionPtr& conn, const std::string& message){
+    std::promise<std::string> echo;
+    size_t expected = message.size();
+    inLoop(loop, [&](){
+        conn->setMessageCallback([&echo, expected](const TcpConnectionPtr&, Buffer* buf, TimeStamp){
+            if(buf->readableBytes() >= expected){
+                echo.set_value(buf->retrieveAllAsString());
+            }
+        });
+        conn->send(message);
+    });
+    return echo.get_future().get();
+}
+
+struct EchoServer{
+    EchoServer(EventLoop* loop, uint16_t port) : server(loop, InetAddress(port), "Upstream"), accepted(0){
+        server.setConnectionCallback([this](const TcpConnectionPtr& conn){
+            if(conn->connected()){
+                ++accepted;
+                conns.push_back(conn);
+            }else{
+                //不再持有，连接才能析构、关掉fd
+                conns.erase(std::remove(conns.begin(), conns.end(), conn), conns.end());
+            }
+        });
+        server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+            conn->send(buf);
+        });
+        server.start();
+    }
+
+    //只在loop线程调用
+    void closeAll(){
+        std::vector<TcpConnectionPtr> all(conns);
+        for(const TcpConnectionPtr& conn : all){
+            conn->forceClose();
+        }
+    }
+
+    TcpServer server;
+    std::atomic<int> accepted;
+    std::vector<TcpConnectionPtr> conns;
+};
+
+void testTcpClient(EventLoop* loop, const InetAddress& addr){
+    std::unique_ptr<TcpClient> client;
+    std::promise<std::string> echo;
+    std::promise<void> down;
+    inLoop(loop, [&](){
+        client.reset(new TcpClient(loop, addr, "Client"));
+        client->setConnectionCallback([&down](const TcpConnectionPtr& conn){
+            if(conn->connected()){
+                conn->send(std::string("hello"));
+            }else{
+                down.set_value();
+            }
+        });
+        client->setMessageCallback([&](const TcpConnectionPtr&, Buffer* buf, TimeStamp){
+            if(buf->readableBytes() >= 5){
+                echo.set_value(buf->retrieveAllAsString());
+                client->disconnect();
+            }
+        });
+        client->connect();
+    });
+    CHECK(echo.get_future().get() == "hello");
+    down.get_future().wait();
+    inLoop(loop, [&](){ client.reset(); });
+}
+
+void testConnector(EventLoop* loop, const InetAddress& live, const InetAddress& dead){
+    std::promise<int> connected;
+    ConnectorPtr ok(new Connector(loop, live));
+    ok->setNewConnectionCallback([&connected](int sockfd){ connected.set_value(sockfd); });
+    ok->start();
+    int sockfd = connected.get_future().get();
+    CHECK(sockfd >= 0);
+    ::close(sockfd);
+
+    //失败一次后至少退避kInitRetryDelayMs(500ms)再试
+    std::promise<void> failed;
+    ConnectorPtr bad(new Connector(loop, dead));
+    bad->setMaxRetries(1);
+    bad->setConnectFailedCallback([&failed](){ failed.set_value(); });
+    auto start = std::chrono::steady_clock::now();
+    bad->start();
+    failed.get_future().wait();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    CHECK(elapsed >= 0.4);
+
+    inLoop(loop, [&](){
+        ok.reset();
+        bad.reset();
+    });
+}
+
+void testPool(EventLoop* loop, EchoServer* server, const InetAddress& addr, const InetAddress& dead){
+    std::unique_ptr<ConnectionPool> pool;
+    inLoop(loop, [&](){ pool.reset(new ConnectionPool(loop, "Pool")); });
+    int acceptedBefore = server->accepted;
+
+    //归还后再借出的是同一个连接，不再握手
+    TcpConnectionPtr first = acquire(loop, pool.get(), addr);
+    CHECK(first && first->connected());
+    CHECK(roundTrip(loop, first, "ping") == "ping");
+    inLoop(loop, [&](){ pool->release(first); });
+    CHECK(waitFor(loop, [&](){ return pool->idleConnections() == 1; }));
+    TcpConnectionPtr again = acquire(loop, pool.get(), addr);
+    CHECK(again == first);
+    CHECK(roundTrip(loop, again, "pong") == "pong");
+    CHECK(server->accepted == acceptedBefore + 1);
+    inLoop(loop, [&](){ pool->release(again); });
+    first.reset();
+    again.reset();
+
+    //对端关掉空闲连接，池子要把它摘掉
+    inLoop(loop, [&](){ server->closeAll(); });
+    CHECK(waitFor(loop, [&](){ return pool->idleConnections() == 0 && pool->connections() == 0; }));
+
+    //每个上游最多留一个空闲连接，多出来的归还时关闭
+    inLoop(loop, [&](){ pool->setMaxIdlePerHost(1); });
+    TcpConnectionPtr a = acquire(loop, pool.get(), addr);
+    TcpConnectionPtr b = acquire(loop, pool.get(), addr);
+    CHECK(a && b && a != b);
+    inLoop(loop, [&](){
+        pool->release(a);
+        pool->release(b);
+    });
+    a.reset();
+    b.reset();
+    CHECK(waitFor(loop, [&](){ return pool->idleConnections() == 1 && pool->connections() == 1; }));
+
+    //连不上的上游，不重试，回调空指针
+    inLoop(loop, [&](){ pool->setConnectRetries(0); });
+    CHECK(!acquire(loop, pool.get(), dead));
+
+    inLoop(loop, [&](){ pool.reset(); });
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(FATAL);
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+
+    uint16_t port = testutil::pickPort();
+    InetAddress addr(port);
+    //拿到端口后不监听，连过去会被拒绝
+    InetAddress dead(testutil::pickPort());
+    std::unique_ptr<EchoServer> server;
+    inLoop(loop, [&](){ server.reset(new EchoServer(loop, port)); });
+
+    testTcpClient(loop, addr);
+    testConnector(loop, addr, dead);
+    testPool(loop, server.get(), addr, dead);
+
+    inLoop(loop, [&](){ server.reset(); });
+    printf("ConnectionPool_test OK\n");
+    return 0;
+}
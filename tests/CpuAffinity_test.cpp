@@ -0,0 +1,86 @@
+//CpuAffinity：绑核只影响调用线程，非法的cpu编号返回false；NUMA节点查询和sysfs一致。
+//EventLoopThreadPool按setCpuAffinity把第i个loop线程绑到cpuSets[i % n]上。只用本进程允许的cpu，单核机器上也能跑
+#include "CpuAffinity.h"
+#include "EventLoop.h"
+#include "EventLoopThreadPool.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <sched.h>
+#include <thread>
+#include <future>
+#include <vector>
+#include <stdio.h>
+
+namespace{
+
+std::vector<int> allowedCpus(){
+    cpu_set_t set;
+    CHECK(::sched_getaffinity(0, sizeof set, &set) == 0);
+    std::vector<int> cpus;
+    for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu){
+        if(CPU_ISSET(cpu, &set)){
+            cpus.push_back(cpu);
+        }
+    }
+    CHECK(!cpus.empty());
+    return cpus;
+}
+
+void testBindThread(const std::vector<int>& cpus){
+    int target = cpus.back();
+    std::thread worker([target](){
+        CHECK(CpuAffinity::bindThisThread(std::vector<int>(1, target)));
+        CHECK(allowedCpus() == std::vector<int>(1, target));
+        CHECK(::sched_getcpu() == target);
+        CHECK(!CpuAffinity::bindThisThread(std::vector<int>()));
+        CHECK(!CpuAffinity::bindThisThread(std::vector<int>(1, -1)));
+        CHECK(!CpuAffinity::bindThisThread(std::vector<int>(1, CPU_SETSIZE)));
+        //失败的调用不改变原来的绑定
+        CHECK(allowedCpus() == std::vector<int>(1, target));
+    });
+    worker.join();
+    //只影响那个线程
+    CHECK(allowedCpus() == cpus);
+}
+
+void testNodes(const std::vector<int>& cpus){
+    int node = CpuAffinity::nodeOfCpu(cpus[0]);
+    CHECK(node >= -1);
+    CHECK(CpuAffinity::commonNode(std::vector<int>(1, cpus[0])) == node);
+    CHECK(CpuAffinity::nodeOfCpu(CPU_SETSIZE) == -1);
+    CHECK(CpuAffinity::commonNode(std::vector<int>()) == -1);
+    CHECK(!CpuAffinity::preferNode(-1));
+}
+
+void testPoolAffinity(const std::vector<int>& cpus){
+    const int kThreads = 3;
+    EventLoop base;
+    EventLoopThreadPool pool(&base, "pinned");
+    pool.setThreadNum(kThreads);
+    std::vector<std::vector<int>> cpuSets;
+    cpuSets.push_back(std::vector<int>(1, cpus.front()));
+    cpuSets.push_back(std::vector<int>(1, cpus.back()));
+    pool.setCpuAffinity(cpuSets, false);
+    pool.start();
+
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+    CHECK(static_cast<int>(loops.size()) == kThreads);
+    for(int i = 0; i < kThreads; ++i){
+        std::promise<std::vector<int>> bound;
+        loops[i]->runInLoop([&bound](){ bound.set_value(allowedCpus()); });
+        CHECK(bound.get_future().get() == cpuSets[i % cpuSets.size()]);
+    }
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(FATAL);
+    std::vector<int> cpus = allowedCpus();
+    testBindThread(cpus);
+    testNodes(cpus);
+    testPoolAffinity(cpus);
+    printf("CpuAffinity_test: %zu cpus allowed OK\n", cpus.size());
+    return 0;
+}
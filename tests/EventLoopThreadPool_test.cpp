@@ -0,0 +1,162 @@
+//EventLoopThreadPool的各个负载均衡策略：轮询按顺序；最少连接/最少待发字节选负载最低的，平手时轮流；
+//两次随机选择偏向空闲loop；一致性哈希同一ip总是同一个loop，加一个loop只迁走一小部分ip
+#include "EventLoopThreadPool.h"
+#include "EventLoop.h"
+#include "InetAddress.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+
+namespace{
+
+const int kThreads = 4;
+
+int indexOf(const std::vector<EventLoop*>& loops, EventLoop* loop){
+    for(size_t i = 0; i < loops.size(); ++i){
+        if(loops[i] == loop){
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+InetAddress peer(int i, uint16_t port = 40000){
+    return InetAddress(port, "10.0." + std::to_string(i / 250) + "." + std::to_string(i % 250 + 1));
+}
+
+void setLoads(const std::vector<EventLoop*>& loops, const std::vector<int>& connections, const std::vector<int64_t>& pending){
+    for(size_t i = 0; i < loops.size(); ++i){
+        loops[i]->addConnectionLoad(connections[i] - loops[i]->connectionLoad());
+        loops[i]->addPendingBytes(pending[i] - loops[i]->pendingBytes());
+    }
+}
+
+void testRoundRobin(EventLoop* base){
+    EventLoopThreadPool pool(base, "rr");
+    pool.setThreadNum(kThreads);
+    pool.start();
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+    for(int i = 0; i < 2 * kThreads; ++i){
+        CHECK(pool.getNextLoop(peer(i)) == loops[i % kThreads]);
+    }
+}
+
+void testLeastLoaded(EventLoop* base){
+    EventLoopThreadPool pool(base, "least");
+    pool.setThreadNum(kThreads);
+    pool.setLoadBalance(EventLoopThreadPool::kLeastConnections);
+    pool.start();
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+
+    setLoads(loops, {5, 1, 3, 1}, {0, 0, 0, 0});
+    //两个平手的loop轮流拿到连接
+    int first = indexOf(loops, pool.getNextLoop(peer(0)));
+    int second = indexOf(loops, pool.getNextLoop(peer(1)));
+    CHECK((first == 1 && second == 3) || (first == 3 && second == 1));
+
+    //模拟连接建立后负载跟着变化
+    loops[1]->addConnectionLoad(3);
+    CHECK(pool.getNextLoop(peer(2)) == loops[3]);
+    setLoads(loops, {0, 0, 0, 0}, {0, 0, 0, 0});
+}
+
+void testLeastPendingBytes(EventLoop* base){
+    EventLoopThreadPool pool(base, "bytes");
+    pool.setThreadNum(kThreads);
+    pool.setLoadBalance(EventLoopThreadPool::kLeastPendingBytes);
+    pool.start();
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+
+    setLoads(loops, {2, 2, 2, 0}, {4096, 10, 1 << 20, 50});
+    CHECK(pool.getNextLoop(peer(0)) == loops[1]);
+    //待发字节相同时看连接数
+    setLoads(loops, {2, 3, 1, 2}, {0, 0, 0, 0});
+    CHECK(pool.getNextLoop(peer(1)) == loops[2]);
+    setLoads(loops, {0, 0, 0, 0}, {0, 0, 0, 0});
+}
+
+void testPowerOfTwoChoices(EventLoop* base){
+    const int kPicks = 4000;
+    EventLoopThreadPool pool(base, "p2c");
+    pool.setThreadNum(kThreads);
+    pool.setLoadBalance(EventLoopThreadPool::kPowerOfTwoChoices);
+    pool.start();
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+
+    //负载相同时大致均匀
+    std::vector<int> counts(kThreads, 0);
+    for(int i = 0; i < kPicks; ++i){
+        ++counts[indexOf(loops, pool.getNextLoop(peer(i)))];
+    }
+    for(int count : counts){
+        CHECK(count > kPicks / kThreads / 2);
+    }
+
+    //唯一空闲的loop只要被抽中就会被选，约占一半，且不会输给更忙的
+    setLoads(loops, {100, 100, 100, 0}, {0, 0, 0, 0});
+    int idle = 0;
+    for(int i = 0; i < kPicks; ++i){
+        if(pool.getNextLoop(peer(i)) == loops[3]){
+            ++idle;
+        }
+    }
+    CHECK(idle > kPicks * 4 / 10 && idle < kPicks * 6 / 10);
+    setLoads(loops, {0, 0, 0, 0}, {0, 0, 0, 0});
+}
+
+//返回每个ip落在第几个loop
+std::vector<int> hashPlacement(EventLoop* base, int threads, int peers){
+    EventLoopThreadPool pool(base, "hash");
+    pool.setThreadNum(threads);
+    pool.setLoadBalance(EventLoopThreadPool::kConsistentHash);
+    pool.start();
+    std::vector<EventLoop*> loops = pool.getAllLoops();
+    std::vector<int> placement;
+    for(int i = 0; i < peers; ++i){
+        int index = indexOf(loops, pool.getNextLoop(peer(i)));
+        //同一ip换端口也落在同一个loop
+        CHECK(indexOf(loops, pool.getNextLoop(peer(i, 50000))) == index);
+        placement.push_back(index);
+    }
+    return placement;
+}
+
+void testConsistentHash(EventLoop* base){
+    const int kPeers = 2000;
+    std::vector<int> four = hashPlacement(base, kThreads, kPeers);
+    std::vector<int> five = hashPlacement(base, kThreads + 1, kPeers);
+
+    std::vector<int> counts(kThreads, 0);
+    int moved = 0;
+    for(int i = 0; i < kPeers; ++i){
+        ++counts[four[i]];
+        //新加的loop只能从原有loop各分走一部分，留下的ip不会在原有loop之间搬动
+        if(five[i] != four[i]){
+            CHECK(five[i] == kThreads);
+            ++moved;
+        }
+    }
+    for(int count : counts){
+        CHECK(count > kPeers / kThreads / 2);
+    }
+    CHECK(moved > 0 && moved < kPeers * 2 / 5);
+    printf("consistent hash: %d of %d peers moved when adding a loop\n", moved, kPeers);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    EventLoop base;
+    testRoundRobin(&base);
+    testLeastLoaded(&base);
+    testLeastPendingBytes(&base);
+    testPowerOfTwoChoices(&base);
+    testConsistentHash(&base);
+    printf("EventLoopThreadPool_test OK\n");
+    return 0;
+}
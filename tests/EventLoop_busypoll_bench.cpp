@@ -0,0 +1,98 @@
+//忙轮询对往返延迟的影响：单连接ping-pong，回显服务的loop分别不开忙轮询、spin 50us、spin 1ms，
+//客户端每两次请求之间再停一段时间（0和200us），停顿超过spin窗口时loop已经回到阻塞等待。
+//统计往返延迟分布，以及loop线程每秒消耗的CPU时间
+//用法：EventLoop_busypoll_bench [每组往返次数=20000] [SO_BUSY_POLL微秒=0]
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "BenchUtil.h"
+#include "TestUtil.h"
+
+#include <future>
+#include <memory>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+#include <netinet/tcp.h>
+
+namespace{
+
+int64_t threadCpuNs(clockid_t clock){
+    struct timespec ts;
+    ::clock_gettime(clock, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void run(int spinUs, int socketBusyPollUs, int gapUs, long roundTrips){
+    EventLoopThread thread;
+    thread.setBusyPoll(spinUs, socketBusyPollUs);
+    EventLoop* loop = thread.startLoop();
+
+    uint16_t port = testutil::pickPort();
+    std::unique_ptr<TcpServer> server;
+    std::promise<clockid_t> started;
+    loop->runInLoop([&](){
+        server.reset(new TcpServer(loop, InetAddress(port), "BusyPollBench"));
+        server->setConnectionCallback([](const TcpConnectionPtr&){});
+        server->setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+            conn->send(buf);
+        });
+        server->start();
+        clockid_t clock;
+        ::pthread_getcpuclockid(::pthread_self(), &clock);
+        started.set_value(clock);
+    });
+    clockid_t loopClock = started.get_future().get();
+
+    int fd = testutil::connectTo(port);
+    CHECK(fd >= 0);
+    int on = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+    std::vector<int64_t> latencies;
+    latencies.reserve(roundTrips);
+    int64_t cpuBefore = threadCpuNs(loopClock);
+    int64_t begin = benchutil::nowNs();
+    char c = 'x';
+    for(long i = 0; i < roundTrips; ++i){
+        if(gapUs > 0){
+            ::usleep(gapUs);
+        }
+        int64_t sent = benchutil::nowNs();
+        CHECK(::write(fd, &c, 1) == 1);
+        CHECK(::read(fd, &c, 1) == 1);
+        latencies.push_back(benchutil::nowNs() - sent);
+    }
+    double wallSeconds = (benchutil::nowNs() - begin) / 1e9;
+    double cpuMsPerSecond = (threadCpuNs(loopClock) - cpuBefore) / 1e6 / wallSeconds;
+    ::close(fd);
+
+    std::promise<void> stopped;
+    loop->runInLoop([&](){
+        server.reset();
+        stopped.set_value();
+    });
+    stopped.get_future().wait();
+
+    char name[64];
+    snprintf(name, sizeof name, "spin=%dus gap=%dus", spinUs, gapUs);
+    benchutil::printLatency(name, &latencies);
+    printf("%-28s loop cpu %.0f ms/s\n", "", cpuMsPerSecond);
+}
+
+}
+
+int main(int argc, char* argv[]){
+    Logger::setLogLevel(ERROR);
+    long roundTrips = benchutil::argOr(argc, argv, 1, 20000);
+    int socketBusyPollUs = static_cast<int>(benchutil::argOr(argc, argv, 2, 0));
+    const int spins[] = {0, 50, 1000};
+    const int gaps[] = {0, 200};
+    for(int gap : gaps){
+        for(int spin : spins){
+            run(spin, socketBusyPollUs, gap, roundTrips);
+        }
+    }
+    return 0;
+}
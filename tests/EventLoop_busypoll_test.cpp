@@ -0,0 +1,67 @@
+//忙轮询：有事件之后的spinUs内loop线程以0超时poll一直占着CPU，之后恢复阻塞等待不再耗CPU；不开忙轮询时空闲不耗CPU。
+//用loop线程自己的CPU时间来判断
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <future>
+#include <pthread.h>
+#include <time.h>
+#include <stdio.h>
+
+namespace{
+
+double cpuMs(clockid_t clock){
+    struct timespec ts;
+    CHECK(::clock_gettime(clock, &ts) == 0);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+//投递一个任务（产生一次wakeup事件），顺便拿到loop线程的CPU时钟
+clockid_t poke(EventLoop* loop){
+    std::promise<clockid_t> clock;
+    loop->runInLoop([&clock](){
+        clockid_t id;
+        CHECK(::pthread_getcpuclockid(::pthread_self(), &id) == 0);
+        clock.set_value(id);
+    });
+    return clock.get_future().get();
+}
+
+double cpuDuring(clockid_t clock, int ms){
+    double start = cpuMs(clock);
+    ::usleep(ms * 1000);
+    return cpuMs(clock) - start;
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+
+    {
+        EventLoopThread thread;
+        thread.setBusyPoll(300 * 1000, 0);
+        EventLoop* loop = thread.startLoop();
+
+        clockid_t clock = poke(loop);
+        double spinning = cpuDuring(clock, 150);
+        //300毫秒的窗口过去之后
+        ::usleep(300 * 1000);
+        double idle = cpuDuring(clock, 200);
+        printf("busy poll: %.1f ms cpu in 150 ms after an event, %.1f ms cpu in 200 ms idle\n", spinning, idle);
+        CHECK(spinning > 50);
+        CHECK(idle < 20);
+    }
+    {
+        EventLoopThread thread;
+        EventLoop* loop = thread.startLoop();
+        clockid_t clock = poke(loop);
+        double blocking = cpuDuring(clock, 150);
+        printf("blocking: %.1f ms cpu in 150 ms after an event\n", blocking);
+        CHECK(blocking < 20);
+    }
+    printf("EventLoop_busypoll_test OK\n");
+    return 0;
+}
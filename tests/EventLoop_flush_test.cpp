@@ -0,0 +1,49 @@
+//flush阶段里本线程投递的任务没有写eventfd，下一轮poll不能阻塞到超时
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <stdio.h>
+
+namespace{
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start){
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+
+    EventLoop loop;
+    Clock::time_point start;
+    double queuedMs = -1;
+    double flushedMs = -1;
+
+    loop.runAfter(0.05, [&](){
+        loop.queueFlush([&](){
+            start = Clock::now();
+            //flush阶段投递普通任务
+            loop.queueInLoop([&](){
+                queuedMs = elapsedMs(start);
+                //普通任务里再投递flush，同样要在本轮末尾执行
+                loop.queueFlush([&](){
+                    flushedMs = elapsedMs(start);
+                    loop.quit();
+                });
+            });
+        });
+    });
+    //兜底：修复前这里会等满poll超时
+    loop.runAfter(5.0, [&](){ loop.quit(); });
+    loop.loop();
+
+    CHECK(queuedMs >= 0 && queuedMs < 1000);
+    CHECK(flushedMs >= 0 && flushedMs < 1000);
+    printf("EventLoop_flush_test: queued %.3f ms, flushed %.3f ms OK\n", queuedMs, flushedMs);
+    return 0;
+}
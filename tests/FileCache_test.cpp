@@ -0,0 +1,121 @@
+//FileCache：同一文件复用同一个CachedFile，文件变了重新打开，超过上限按LRU淘汰；
+//sendFile和前后send的数据保持顺序，shutdown等文件发完才关写端
+#include "FileCache.h"
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <string>
+#include <fcntl.h>
+#include <stdio.h>
+
+namespace{
+
+const size_t kFileSize = 3 * 1024 * 1024 + 123;
+
+std::string pattern(size_t len){
+    std::string s(len, '\0');
+    for(size_t i = 0; i < len; ++i){
+        s[i] = static_cast<char>(i * 7 % 253);
+    }
+    return s;
+}
+
+void writeFile(const std::string& path, const std::string& content){
+    FILE* fp = ::fopen(path.c_str(), "w");
+    CHECK(fp != nullptr);
+    CHECK(::fwrite(content.data(), 1, content.size(), fp) == content.size());
+    ::fclose(fp);
+}
+
+void testCache(const std::string& dir){
+    std::string a = dir + "/a";
+    std::string b = dir + "/b";
+    std::string c = dir + "/c";
+    writeFile(a, "aaaa");
+    writeFile(b, "bb");
+    writeFile(c, "c");
+
+    FileCache cache(2);
+    CHECK(cache.open(dir + "/missing") == nullptr);
+    CachedFilePtr first = cache.open(a);
+    CHECK(first != nullptr && first->size() == 4);
+    CHECK(cache.open(a) == first);
+
+    //文件大小变了，要重新打开
+    writeFile(a, "aaaaaaaa");
+    CachedFilePtr reopened = cache.open(a);
+    CHECK(reopened != first && reopened->size() == 8);
+    CHECK(cache.size() == 1);
+
+    //a最久没用，被淘汰；被淘汰的CachedFile在用户手里仍然有效
+    CHECK(cache.open(b) != nullptr);
+    CHECK(cache.open(c) != nullptr);
+    CHECK(cache.size() == 2);
+    CHECK(cache.open(a) != reopened);
+    char byte;
+    CHECK(::pread(reopened->fd(), &byte, 1, 0) == 1 && byte == 'a');
+
+    cache.invalidate(a);
+    CHECK(cache.size() == 1);
+}
+
+void testSendFile(const std::string& path, const std::string& content){
+    EventLoop loop;
+    FileCache cache;
+    CachedFilePtr file = cache.open(path);
+    CHECK(file != nullptr && file->size() == content.size());
+
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "SendFileTest");
+    server.setThreadNum(1);
+    server.setConnectionCallback([&file](const TcpConnectionPtr& conn){
+        if(conn->connected()){
+            conn->send(std::string("HEAD"));
+            conn->sendFile(file, 100, file->size() - 100);
+            conn->send(std::string("MIDDLE"));
+            conn->sendFile(file, 0, 10);
+            conn->send(std::string("TAIL"));
+            conn->shutdown();
+        }
+    });
+    server.start();
+
+    std::string received;
+    std::thread client([&](){
+        int fd = testutil::connectTo(port);
+        CHECK(fd >= 0);
+        received = testutil::readUntilEof(fd);
+        ::close(fd);
+        loop.queueInLoop([&loop](){ loop.quit(); });
+    });
+    loop.loop();
+    client.join();
+
+    CHECK(received == "HEAD" + content.substr(100) + "MIDDLE" + content.substr(0, 10) + "TAIL");
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    char dir[] = "/tmp/mymuduo_fileXXXXXX";
+    CHECK(::mkdtemp(dir) != nullptr);
+
+    testCache(dir);
+
+    std::string path = std::string(dir) + "/big";
+    std::string content = pattern(kFileSize);
+    writeFile(path, content);
+    testSendFile(path, content);
+
+    for(const char* name : {"/a", "/b", "/c", "/big"}){
+        ::unlink((std::string(dir) + name).c_str());
+    }
+    ::rmdir(dir);
+    printf("FileCache_test OK\n");
+    return 0;
+}
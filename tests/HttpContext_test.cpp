@@ -0,0 +1,144 @@
+//HttpContext：出错后reset、chunked各项上限、Transfer-Encoding的判定、逐字节到达和流水线
+#include "HttpContext.h"
+#include "HttpRequest.h"
+#include "Buffer.h"
+#include "TimeStamp.h"
+#include "TestUtil.h"
+
+#include <string>
+#include <stdio.h>
+
+namespace{
+
+std::string str(StringPiece piece){
+    return std::string(piece.data(), piece.size());
+}
+
+HttpContext::ParseResult feed(HttpContext* context, Buffer* buf, const std::string& data){
+    buf->append(data.data(), data.size());
+    return context->parse(buf, TimeStamp::now());
+}
+
+//出错后buf被清空，reset之后再来数据不能用旧偏移去找
+void testResetAfterError(){
+    HttpContext context;
+    Buffer buf;
+    CHECK(feed(&context, &buf, "GET / HTTP/1.1\r\nHost: x\r\nContent-Length: abc\r\n\r\n") == HttpContext::kError);
+    CHECK(context.errorStatus() == 400);
+    buf.retrieveAll();
+    context.reset();
+
+    CHECK(feed(&context, &buf, "G") == HttpContext::kNeedMore);
+    CHECK(feed(&context, &buf, "ET /a HTTP/1.1\r\n\r\n") == HttpContext::kComplete);
+    CHECK(str(context.request().path()) == "/a");
+    context.finishRequest(&buf);
+    CHECK(buf.readableBytes() == 0);
+}
+
+void testChunkSizeLineLimit(){
+    HttpContext context;
+    Buffer buf;
+    CHECK(feed(&context, &buf, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n") == HttpContext::kNeedMore);
+    //一直不给换行的块大小行
+    std::string junk(HttpContext::kMaxHeaderBytes / 2, 'a');
+    CHECK(feed(&context, &buf, junk) == HttpContext::kNeedMore);
+    CHECK(feed(&context, &buf, junk + "a") == HttpContext::kError);
+    CHECK(context.errorStatus() == 400);
+}
+
+void testTrailerLimit(){
+    HttpContext context;
+    Buffer buf;
+    CHECK(feed(&context, &buf, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n3\r\nabc\r\n0\r\n") == HttpContext::kNeedMore);
+    std::string trailer = "X-Trailer: " + std::string(1000, 't') + "\r\n";
+    HttpContext::ParseResult result = HttpContext::kNeedMore;
+    size_t sent = 0;
+    while(result == HttpContext::kNeedMore && sent <= 2 * HttpContext::kMaxHeaderBytes){
+        result = feed(&context, &buf, trailer);
+        sent += trailer.size();
+    }
+    CHECK(result == HttpContext::kError);
+    CHECK(context.errorStatus() == 431);
+    CHECK(sent <= HttpContext::kMaxHeaderBytes + trailer.size());
+}
+
+//块数据在inputBuffer和chunkedBody_里各一份，一半上限以上的块就要拒绝
+void testChunkedBodyLimit(){
+    {
+        HttpContext context;
+        Buffer buf;
+        char line[32];
+        snprintf(line, sizeof line, "%zx\r\n", HttpContext::kMaxBodyBytes / 2 + 1);
+        CHECK(feed(&context, &buf, std::string("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n") + line) == HttpContext::kError);
+        CHECK(context.errorStatus() == 413);
+    }
+    {
+        HttpContext context;
+        Buffer buf;
+        CHECK(feed(&context, &buf, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n100000\r\n") == HttpContext::kNeedMore);
+    }
+}
+
+HttpContext::ParseResult parseHeaders(const std::string& headers, int* status){
+    HttpContext context;
+    Buffer buf;
+    HttpContext::ParseResult result = feed(&context, &buf, "POST / HTTP/1.1\r\n" + headers + "\r\n0\r\n\r\n");
+    *status = context.errorStatus();
+    return result;
+}
+
+void testTransferEncoding(){
+    int status = 0;
+    CHECK(parseHeaders("Transfer-Encoding: xchunked\r\n", &status) == HttpContext::kError);
+    CHECK(status == 501);
+    CHECK(parseHeaders("Transfer-Encoding: chunked, gzip\r\n", &status) == HttpContext::kError);
+    CHECK(status == 501);
+    CHECK(parseHeaders("Transfer-Encoding: gzip , Chunked \r\n", &status) == HttpContext::kComplete);
+    //Content-Length和Transfer-Encoding同时出现是请求走私的手法，拒绝
+    CHECK(parseHeaders("Content-Length: 5\r\nTransfer-Encoding: chunked\r\n", &status) == HttpContext::kError);
+    CHECK(status == 400);
+    CHECK(parseHeaders("Transfer-Encoding: chunked\r\nContent-Length: 5\r\n", &status) == HttpContext::kError);
+    CHECK(status == 400);
+}
+
+void testChunkedAndPipelined(){
+    HttpContext context;
+    Buffer buf;
+    std::string requests =
+        "POST /upload HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\nX-Sum: 1\r\n\r\n"
+        "GET /next?q=1 HTTP/1.0\r\nConnection: keep-alive\r\n\r\n";
+    //逐字节到达
+    HttpContext::ParseResult result = HttpContext::kNeedMore;
+    size_t i = 0;
+    for(; i < requests.size() && result == HttpContext::kNeedMore; ++i){
+        result = feed(&context, &buf, requests.substr(i, 1));
+    }
+    CHECK(result == HttpContext::kComplete);
+    CHECK(context.request().method() == HttpRequest::kPost);
+    CHECK(str(context.request().body()) == "hello world");
+    CHECK(context.request().keepAlive());
+    context.finishRequest(&buf);
+
+    result = feed(&context, &buf, requests.substr(i));
+    CHECK(result == HttpContext::kComplete);
+    CHECK(str(context.request().path()) == "/next");
+    CHECK(str(context.request().query()) == "q=1");
+    CHECK(context.request().version() == HttpRequest::kHttp10);
+    CHECK(context.request().keepAlive());
+    context.finishRequest(&buf);
+    CHECK(buf.readableBytes() == 0);
+}
+
+}
+
+int main(){
+    testResetAfterError();
+    testChunkSizeLineLimit();
+    testTrailerLimit();
+    testChunkedBodyLimit();
+    testTransferEncoding();
+    testChunkedAndPipelined();
+    printf("HttpContext_test OK\n");
+    return 0;
+}
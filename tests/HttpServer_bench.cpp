@@ -0,0 +1,135 @@
+//类似wrk的HTTP压测：若干keep-alive连接各自 发请求-收完应答-再发，可选每次流水线发depth个请求，
+//统计每秒完成的请求数和每批请求的延迟分布。服务端和客户端在同一进程的不同loop里
+//用法：HttpServer_bench [连接数=32] [服务端subLoop数=2] [秒数=3] [流水线深度=1] [应答body字节数=13]
+#include "HttpServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "TcpClient.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "BenchUtil.h"
+#include "TestUtil.h"
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace{
+
+//data开头一个完整应答的长度，还不完整返回0。应答都带Content-Length
+size_t responseLength(const char* data, size_t len){
+    static const char kEnd[] = "\r\n\r\n";
+    static const char kContentLength[] = "Content-Length: ";
+    const char* end = std::search(data, data + len, kEnd, kEnd + 4);
+    if(end == data + len){
+        return 0;
+    }
+    size_t headLen = end - data + 4;
+    const char* field = std::search(data, end, kContentLength, kContentLength + sizeof kContentLength - 1);
+    size_t bodyLen = field == end ? 0 : static_cast<size_t>(::atol(field + sizeof kContentLength - 1));
+    return len >= headLen + bodyLen ? headLen + bodyLen : 0;
+}
+
+struct Client{
+    std::unique_ptr<TcpClient> client;
+    int outstanding;
+    int64_t sentAt;
+};
+
+}
+
+int main(int argc, char* argv[]){
+    Logger::setLogLevel(ERROR);
+    int connections = static_cast<int>(benchutil::argOr(argc, argv, 1, 32));
+    int threads = static_cast<int>(benchutil::argOr(argc, argv, 2, 2));
+    double seconds = static_cast<double>(benchutil::argOr(argc, argv, 3, 3));
+    int depth = static_cast<int>(benchutil::argOr(argc, argv, 4, 1));
+    size_t bodySize = static_cast<size_t>(benchutil::argOr(argc, argv, 5, 13));
+
+    EventLoopThread serverThread;
+    EventLoop* serverLoop = serverThread.startLoop();
+    uint16_t port = testutil::pickPort();
+    const std::string body(bodySize, 'b');
+    std::unique_ptr<HttpServer> server;
+    std::promise<void> started;
+    serverLoop->runInLoop([&](){
+        server.reset(new HttpServer(serverLoop, InetAddress(port), "HttpBench"));
+        server->setThreadNum(threads);
+        server->setHttpCallback([&body](const HttpRequest&, HttpResponse* response){
+            response->setStatusCode(200);
+            response->setContentType("text/plain");
+            response->setBody(body);
+        });
+        server->start();
+        started.set_value();
+    });
+    started.get_future().wait();
+
+    EventLoop clientLoop;
+    std::string batch;
+    for(int i = 0; i < depth; ++i){
+        batch += "GET /bench HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    }
+    bool measuring = false;
+    bool running = true;
+    long requests = 0;
+    std::vector<int64_t> latencies;
+    std::vector<Client> clients(connections);
+    for(Client& c : clients){
+        c.outstanding = 0;
+        c.client.reset(new TcpClient(&clientLoop, InetAddress(port), "HttpBenchClient"));
+        Client* self = &c;
+        c.client->setConnectionCallback([self, &batch, depth](const TcpConnectionPtr& conn){
+            if(conn->connected()){
+                self->outstanding = depth;
+                self->sentAt = benchutil::nowNs();
+                conn->send(batch);
+            }
+        });
+        c.client->setMessageCallback([&, self](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+            size_t n;
+            while((n = responseLength(buf->peek(), buf->readableBytes())) > 0){
+                buf->retrieve(n);
+                if(--self->outstanding > 0){
+                    continue;
+                }
+                int64_t now = benchutil::nowNs();
+                if(measuring){
+                    requests += depth;
+                    latencies.push_back(now - self->sentAt);
+                }
+                if(running){
+                    self->outstanding = depth;
+                    self->sentAt = now;
+                    conn->send(batch);
+                }
+            }
+        });
+        c.client->connect();
+    }
+    //预热0.5秒，连接都建立之后再计数
+    clientLoop.runAfter(0.5, [&](){ measuring = true; });
+    clientLoop.runAfter(0.5 + seconds, [&](){
+        measuring = false;
+        running = false;
+        clientLoop.quit();
+    });
+    clientLoop.loop();
+
+    printf("connections=%d threads=%d depth=%d body=%zu: %.0f requests/s\n",
+        connections, threads, depth, bodySize, requests / seconds);
+    benchutil::printLatency("batch latency", &latencies);
+
+    clients.clear();
+    std::promise<void> stopped;
+    serverLoop->runInLoop([&](){
+        server.reset();
+        stopped.set_value();
+    });
+    stopped.get_future().wait();
+    return 0;
+}
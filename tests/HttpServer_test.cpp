@@ -0,0 +1,93 @@
+//坏请求回400后只关写端，对端之后发来的数据要丢弃，不能再进请求回调；HTTP/1.0 keep-alive的应答要带Connection: keep-alive
+#include "HttpServer.h"
+#include "HttpRequest.h"
+#include "HttpResponse.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <atomic>
+#include <string>
+
+namespace{
+
+std::atomic<int> g_requests(0);
+
+//应答都没有body，读到头部结束为止
+std::string readHead(int fd){
+    std::string head;
+    char c;
+    while(head.size() < 4 || head.compare(head.size() - 4, 4, "\r\n\r\n") != 0){
+        CHECK(::read(fd, &c, 1) == 1);
+        head.push_back(c);
+    }
+    return head;
+}
+
+void testBadRequest(uint16_t port){
+    int fd = testutil::connectTo(port);
+    CHECK(fd >= 0);
+    testutil::sendAll(fd, "GET / HTTP/1.1\r\nHost: x\r\nContent-Length: abc\r\n\r\n");
+    std::string response = testutil::readUntilEof(fd);
+    CHECK(response.compare(0, 12, "HTTP/1.1 400") == 0);
+    //服务端只关了写端，这些数据还会被读到
+    testutil::sendAll(fd, "x");
+    testutil::sendAll(fd, "GET / HTTP/1.1\r\n\r\n");
+    usleep(100 * 1000);
+    ::close(fd);
+
+    //服务端仍然正常工作
+    fd = testutil::connectTo(port);
+    CHECK(fd >= 0);
+    testutil::sendAll(fd, "GET /ok HTTP/1.1\r\nConnection: close\r\n\r\n");
+    response = testutil::readUntilEof(fd);
+    CHECK(response.compare(0, 12, "HTTP/1.1 200") == 0);
+    ::close(fd);
+    //只有最后那个/ok请求到达回调
+    CHECK(g_requests == 1);
+}
+
+void testHttp10KeepAlive(uint16_t port){
+    int fd = testutil::connectTo(port);
+    CHECK(fd >= 0);
+    for(int i = 0; i < 2; ++i){
+        testutil::sendAll(fd, "GET /ok HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+        std::string head = readHead(fd);
+        CHECK(head.compare(0, 12, "HTTP/1.1 200") == 0);
+        CHECK(head.find("Connection: keep-alive\r\n") != std::string::npos);
+    }
+    //没要求keep-alive的1.0请求照旧关闭
+    testutil::sendAll(fd, "GET /ok HTTP/1.0\r\n\r\n");
+    std::string response = testutil::readUntilEof(fd);
+    CHECK(response.find("Connection: close\r\n") != std::string::npos);
+    ::close(fd);
+}
+
+void client(uint16_t port, EventLoop* serverLoop){
+    testBadRequest(port);
+    testHttp10KeepAlive(port);
+    serverLoop->quit();
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    HttpServer server(&loop, InetAddress(port), "HttpTest");
+    server.setHttpCallback([](const HttpRequest& request, HttpResponse* response){
+        ++g_requests;
+        response->setStatusCode(std::string(request.path().data(), request.path().size()) == "/ok" ? 200 : 404);
+    });
+    server.start();
+
+    std::thread clientThread(client, port, &loop);
+    loop.loop();
+    clientThread.join();
+
+    printf("HttpServer_test OK\n");
+    return 0;
+}
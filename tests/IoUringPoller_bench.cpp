@@ -0,0 +1,110 @@
+//回显吞吐，io_uring后端对比epoll：同一个回显服务分别用两种poller各跑一遍，客户端始终用epoll。
+//每个连接发一条消息、收到回显再发下一条，统计每秒往返次数和poller的增删改调用数
+//用法：IoUringPoller_bench [连接数=16] [消息字节数=64] [秒数=3]
+#include "TcpServer.h"
+#include "TcpClient.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "BenchUtil.h"
+#include "TestUtil.h"
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+
+namespace{
+
+struct Result{
+    uint64_t roundTrips;
+    uint64_t ctlCalls;
+};
+
+Result run(bool ioUring, int connections, size_t messageSize, double seconds){
+    if(ioUring){
+        ::setenv("MUDUO_USE_IO_URING", "1", 1);
+    }
+    EventLoopThread serverThread;
+    EventLoop* serverLoop = serverThread.startLoop();
+    ::unsetenv("MUDUO_USE_IO_URING");
+
+    uint16_t port = testutil::pickPort();
+    std::unique_ptr<TcpServer> server;
+    std::promise<void> started;
+    serverLoop->runInLoop([&](){
+        server.reset(new TcpServer(serverLoop, InetAddress(port), "EchoBench"));
+        server->setConnectionCallback([](const TcpConnectionPtr&){});
+        server->setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+            conn->send(buf);
+        });
+        server->start();
+        started.set_value();
+    });
+    started.get_future().wait();
+    uint64_t ctlBefore = 0;
+
+    EventLoop clientLoop;
+    const std::string message(messageSize, 'x');
+    uint64_t roundTrips = 0;
+    bool running = true;
+    std::vector<std::unique_ptr<TcpClient>> clients;
+    for(int i = 0; i < connections; ++i){
+        clients.emplace_back(new TcpClient(&clientLoop, InetAddress(port), "EchoBenchClient"));
+        clients.back()->setConnectionCallback([&message](const TcpConnectionPtr& conn){
+            if(conn->connected()){
+                conn->send(message);
+            }
+        });
+        clients.back()->setMessageCallback([&](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+            while(buf->readableBytes() >= messageSize){
+                buf->retrieve(messageSize);
+                ++roundTrips;
+                if(running){
+                    conn->send(message);
+                }
+            }
+        });
+        clients.back()->connect();
+    }
+    //连接都建立后再开始计数
+    clientLoop.runAfter(0.2, [&](){
+        roundTrips = 0;
+        ctlBefore = serverLoop->pollerCtlCalls();
+    });
+    clientLoop.runAfter(0.2 + seconds, [&](){
+        running = false;
+        clientLoop.quit();
+    });
+    clientLoop.loop();
+
+    Result result = {roundTrips, serverLoop->pollerCtlCalls() - ctlBefore};
+    clients.clear();
+    std::promise<void> stopped;
+    serverLoop->runInLoop([&](){
+        server.reset();
+        stopped.set_value();
+    });
+    stopped.get_future().wait();
+    return result;
+}
+
+}
+
+int main(int argc, char* argv[]){
+    Logger::setLogLevel(ERROR);
+    int connections = static_cast<int>(benchutil::argOr(argc, argv, 1, 16));
+    size_t messageSize = static_cast<size_t>(benchutil::argOr(argc, argv, 2, 64));
+    double seconds = static_cast<double>(benchutil::argOr(argc, argv, 3, 3));
+
+    const bool backends[] = {false, true};
+    for(bool ioUring : backends){
+        Result result = run(ioUring, connections, messageSize, seconds);
+        printf("%-8s connections=%d size=%zu: %.0f round trips/s, %.1f poller ctl calls/s\n",
+            ioUring ? "io_uring" : "epoll", connections, messageSize,
+            result.roundTrips / seconds, result.ctlCalls / seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+//MUDUO_USE_IO_URING下用io_uring后端跑回显，水平触发和边沿触发各一遍；
+//子进程里用seccomp让io_uring_setup失败，EventLoop要退回epoll并照常工作
+#include "IoUringPoller.h"
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <atomic>
+#include <string>
+#include <stddef.h>
+#include <errno.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+
+namespace{
+
+const size_t kBulk = 1024 * 1024;
+const int kSmallMessages = 20;
+
+void echoClient(uint16_t port, std::atomic<bool>* done){
+    int fd = testutil::connectTo(port);
+    CHECK(fd >= 0);
+    for(int i = 0; i < kSmallMessages; ++i){
+        std::string message = "small " + std::to_string(i);
+        testutil::sendAll(fd, message);
+        std::string echo(message.size(), '\0');
+        CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+        CHECK(echo == message);
+    }
+
+    std::string bulk(kBulk, '\0');
+    for(size_t i = 0; i < kBulk; ++i){
+        bulk[i] = static_cast<char>(i % 249);
+    }
+    std::thread writer([fd, &bulk](){ testutil::sendAll(fd, bulk); });
+    std::string echo(kBulk, '\0');
+    CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+    writer.join();
+    CHECK(echo == bulk);
+    ::close(fd);
+    *done = true;
+}
+
+void testEcho(bool edgeTriggered){
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "UringEcho");
+    server.setThreadNum(2);
+    server.setEdgeTriggered(edgeTriggered);
+    server.setConnectionCallback([](const TcpConnectionPtr&){});
+    server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+        conn->send(buf);
+    });
+    server.start();
+
+    //由定时器发现客户端结束并退出，顺带验证timerfd在这个后端上正常
+    std::atomic<bool> done(false);
+    loop.runEvery(0.005, [&loop, &done](){
+        if(done){
+            loop.quit();
+        }
+    });
+    std::thread client(echoClient, port, &done);
+    loop.loop();
+    client.join();
+}
+
+//io_uring_setup返回ENOSYS，其他系统调用照常
+void blockIoUringSetup(){
+    struct sock_filter filter[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_setup, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | (ENOSYS & SECCOMP_RET_DATA)),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+    };
+    struct sock_fprog prog;
+    prog.len = static_cast<unsigned short>(sizeof filter / sizeof filter[0]);
+    prog.filter = filter;
+    CHECK(::prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0);
+    CHECK(::prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0);
+}
+
+void testFallback(){
+    pid_t pid = ::fork();
+    CHECK(pid >= 0);
+    if(pid == 0){
+        //退回epoll时会打一条ERROR日志，子进程里不需要
+        Logger::setLogLevel(FATAL);
+        blockIoUringSetup();
+        {
+            EventLoop loop;
+            IoUringPoller probe(&loop);
+            CHECK(!probe.valid());
+        }
+        testEcho(false);
+        ::_exit(0);
+    }
+    int status = 0;
+    CHECK(::waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    ::setenv("MUDUO_USE_IO_URING", "1", 1);
+
+    bool available = false;
+    {
+        EventLoop loop;
+        IoUringPoller probe(&loop);
+        available = probe.valid();
+    }
+    testEcho(false);
+    testEcho(true);
+    testFallback();
+    printf("IoUringPoller_test: echo on %s, epoll fallback OK\n", available ? "io_uring" : "epoll (io_uring unavailable)");
+    return 0;
+}
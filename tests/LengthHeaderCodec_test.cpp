@@ -0,0 +1,140 @@
+//LengthHeaderCodec：五种长度头的编码；一次到达多帧、逐字节到达都能正确分帧并原样回显；
+//超过maxFrameSize的长度头、非法的varint直接报错关连接；发送超过上限的帧被丢弃，不影响后面的帧
+#include "LengthHeaderCodec.h"
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace{
+
+const size_t kMaxFrameSize = 100 * 1000;
+//回显服务收到这一帧时先发一个超过上限的帧，再发kAfterOverflow
+const char kOverflow[] = "overflow";
+const char kAfterOverflow[] = "after";
+
+std::string frame(const LengthHeaderCodec& codec, const std::string& body){
+    char header[LengthHeaderCodec::kMaxVarintBytes];
+    size_t headerLen = codec.encodeHeader(body.size(), header);
+    return std::string(header, headerLen) + body;
+}
+
+void testEncodeHeader(){
+    char out[LengthHeaderCodec::kMaxVarintBytes];
+    LengthHeaderCodec varint(LengthHeaderCodec::FrameCallback(), LengthHeaderCodec::kVarint);
+    CHECK(std::string(out, varint.encodeHeader(0, out)) == std::string(1, '\0'));
+    CHECK(std::string(out, varint.encodeHeader(127, out)) == "\x7f");
+    CHECK(std::string(out, varint.encodeHeader(300, out)) == "\xac\x02");
+    CHECK(varint.encodeHeader(UINT64_MAX, out) == LengthHeaderCodec::kMaxVarintBytes);
+
+    LengthHeaderCodec int16(LengthHeaderCodec::FrameCallback(), LengthHeaderCodec::kInt16);
+    CHECK(std::string(out, int16.encodeHeader(258, out)) == "\x01\x02");
+    LengthHeaderCodec int32(LengthHeaderCodec::FrameCallback(), LengthHeaderCodec::kInt32);
+    CHECK(std::string(out, int32.encodeHeader(258, out)) == std::string("\0\0\x01\x02", 4));
+    LengthHeaderCodec int64(LengthHeaderCodec::FrameCallback(), LengthHeaderCodec::kInt64);
+    CHECK(std::string(out, int64.encodeHeader(258, out)) == std::string("\0\0\0\0\0\0\x01\x02", 8));
+}
+
+void testFraming(LengthHeaderCodec::HeaderType type){
+    //帧长上限：1/2字节的头取它能表示的最大长度，其余用kMaxFrameSize
+    const size_t limit = type == LengthHeaderCodec::kInt8 ? 255 : (type == LengthHeaderCodec::kInt16 ? 65535 : kMaxFrameSize);
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "CodecTest");
+
+    std::atomic<int> frames(0);
+    std::atomic<int> errors(0);
+    LengthHeaderCodec codec([&](const TcpConnectionPtr& conn, const char* data, size_t len, TimeStamp){
+        ++frames;
+        std::string body(data, len);
+        if(body == kOverflow){
+            std::string big(limit + 1, 'x');
+            codec.send(conn, big.data(), big.size());
+            codec.send(conn, kAfterOverflow, strlen(kAfterOverflow));
+        }else{
+            codec.send(conn, data, len);
+        }
+    }, type, limit);
+    codec.setErrorCallback([&errors](const TcpConnectionPtr& conn){
+        ++errors;
+        conn->forceClose();
+    });
+    server.setConnectionCallback([](const TcpConnectionPtr&){});
+    server.setMessageCallback(std::bind(&LengthHeaderCodec::onMessage, &codec,
+        std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+    server.start();
+
+    std::thread client([&](){
+        int fd = testutil::connectTo(port);
+        CHECK(fd >= 0);
+        std::vector<std::string> bodies = {"", "a", std::string(200, 'b'), std::string(limit, 'c')};
+
+        //多帧一次写出去
+        std::string batch;
+        for(const std::string& body : bodies){
+            batch += frame(codec, body);
+        }
+        testutil::sendAll(fd, batch);
+        std::string echo(batch.size(), '\0');
+        CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+        CHECK(echo == batch);
+
+        //逐字节到达，长度头也被拆开
+        std::string split = frame(codec, std::string(std::min<size_t>(limit, 300), 'd'));
+        for(char c : split){
+            testutil::sendAll(fd, &c, 1);
+        }
+        echo.assign(split.size(), '\0');
+        CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+        CHECK(echo == split);
+
+        //超过上限的帧发不出去，后面的帧照常
+        testutil::sendAll(fd, frame(codec, kOverflow));
+        std::string after = frame(codec, kAfterOverflow);
+        echo.assign(after.size(), '\0');
+        CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+        CHECK(echo == after);
+
+        //非法长度头：服务端报错并关闭，不会等着收完这一帧
+        std::string bad;
+        if(type == LengthHeaderCodec::kVarint){
+            bad.assign(LengthHeaderCodec::kMaxVarintBytes, '\xff');
+        }else if(type == LengthHeaderCodec::kInt32 || type == LengthHeaderCodec::kInt64){
+            char header[LengthHeaderCodec::kMaxVarintBytes];
+            bad.assign(header, codec.encodeHeader(kMaxFrameSize + 1, header));
+        }
+        if(!bad.empty()){
+            testutil::sendAll(fd, bad + "tail");
+            CHECK(testutil::readUntilEof(fd).empty());
+        }
+        ::close(fd);
+        loop.queueInLoop([&loop](){ loop.quit(); });
+    });
+    loop.loop();
+    client.join();
+
+    CHECK(frames == 6);
+    //kInt8/kInt16的上限就是头能表示的最大长度，没有非法长度头
+    CHECK(errors == (type == LengthHeaderCodec::kInt8 || type == LengthHeaderCodec::kInt16 ? 0 : 1));
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(FATAL);
+    testEncodeHeader();
+    testFraming(LengthHeaderCodec::kVarint);
+    testFraming(LengthHeaderCodec::kInt8);
+    testFraming(LengthHeaderCodec::kInt16);
+    testFraming(LengthHeaderCodec::kInt32);
+    testFraming(LengthHeaderCodec::kInt64);
+    printf("LengthHeaderCodec_test OK\n");
+    return 0;
+}
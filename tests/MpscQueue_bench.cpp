@@ -0,0 +1,90 @@
+//生产者争用下的投递吞吐：1~64个生产者同时push、一个消费者pop，MpscQueue对比 mutex+vector（消费者整批swap出来，即原来pendingFunctors_的做法）
+//用法：MpscQueue_bench [总条数=2000000]
+#include "MpscQueue.h"
+#include "BenchUtil.h"
+
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <atomic>
+
+namespace{
+
+class LockedQueue{
+public:
+    void push(long value){
+        std::lock_guard<std::mutex> lock(mutex_);
+        items_.push_back(value);
+    }
+
+    //整批取走，返回取到的条数
+    size_t popAll(std::vector<long>* out){
+        out->clear();
+        std::lock_guard<std::mutex> lock(mutex_);
+        out->swap(items_);
+        return out->size();
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<long> items_;
+};
+
+template <typename PushFunc, typename DrainFunc>
+double run(int producers, long total, PushFunc push, DrainFunc drain){
+    const long perProducer = total / producers;
+    std::atomic<bool> start(false);
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p){
+        threads.emplace_back([&](){
+            while(!start){
+                std::this_thread::yield();
+            }
+            for(long i = 0; i < perProducer; ++i){
+                push(i);
+            }
+        });
+    }
+    int64_t begin = benchutil::nowNs();
+    start = true;
+    long consumed = 0;
+    const long expected = perProducer * producers;
+    while(consumed < expected){
+        long n = drain();
+        if(n == 0){
+            std::this_thread::yield();
+        }
+        consumed += n;
+    }
+    int64_t elapsed = benchutil::nowNs() - begin;
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    return expected * 1e9 / elapsed;
+}
+
+}
+
+int main(int argc, char* argv[]){
+    long total = benchutil::argOr(argc, argv, 1, 2000000);
+    const int producerCounts[] = {1, 2, 4, 8, 16, 32, 64};
+    for(int producers : producerCounts){
+        MpscQueue<long> mpsc;
+        double mpscRate = run(producers, total, [&mpsc](long v){ mpsc.push(v); }, [&mpsc](){
+            long n = 0;
+            long value;
+            while(mpsc.pop(&value)){
+                ++n;
+            }
+            return n;
+        });
+
+        LockedQueue locked;
+        std::vector<long> batch;
+        double lockedRate = run(producers, total, [&locked](long v){ locked.push(v); }, [&](){
+            return static_cast<long>(locked.popAll(&batch));
+        });
+        printf("producers=%-3d MpscQueue %11.0f items/s   mutex+vector %11.0f items/s\n", producers, mpscRate, lockedRate);
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+//MpscQueue：多个生产者并发push、消费者同时pop，不丢不重，每个生产者内部保持FIFO；析构时释放剩下的元素。
+//EventLoop::queueInLoop：多线程断断续续地投递，合并后的唤醒不能丢，每个线程的任务按投递顺序执行
+#include "MpscQueue.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <stdio.h>
+
+namespace{
+
+const int kProducers = 8;
+const int kItems = 100000;
+
+void testQueue(){
+    MpscQueue<std::pair<int, int>> queue;
+    std::atomic<bool> start(false);
+    std::vector<std::thread> producers;
+    for(int p = 0; p < kProducers; ++p){
+        producers.emplace_back([&queue, &start, p](){
+            while(!start){
+            }
+            for(int i = 0; i < kItems; ++i){
+                queue.push(std::make_pair(p, i));
+            }
+        });
+    }
+    start = true;
+
+    std::vector<int> next(kProducers, 0);
+    int popped = 0;
+    std::pair<int, int> item;
+    while(popped < kProducers * kItems){
+        if(queue.pop(&item)){
+            CHECK(item.first >= 0 && item.first < kProducers);
+            CHECK(item.second == next[item.first]);
+            ++next[item.first];
+            ++popped;
+        }
+    }
+    for(std::thread& thread : producers){
+        thread.join();
+    }
+    CHECK(!queue.pop(&item));
+}
+
+void testDestroyReleasesItems(){
+    std::shared_ptr<int> tracked = std::make_shared<int>(0);
+    {
+        MpscQueue<std::shared_ptr<int>> queue;
+        for(int i = 0; i < 10; ++i){
+            queue.push(tracked);
+        }
+        std::shared_ptr<int> one;
+        CHECK(queue.pop(&one));
+        CHECK(tracked.use_count() == 11);
+    }
+    CHECK(tracked.use_count() == 1);
+}
+
+//每个线程每投递一批就歇一会儿，loop经常睡在epoll_wait里，每一批都要靠唤醒
+void testQueueInLoop(){
+    const int kThreads = 4;
+    const int kBatches = 200;
+    const int kBatchSize = 50;
+
+    EventLoop loop;
+    std::vector<int> next(kThreads, 0);
+    int executed = 0;
+    bool ordered = true;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < kThreads; ++t){
+        threads.emplace_back([&, t](){
+            for(int b = 0; b < kBatches; ++b){
+                for(int i = 0; i < kBatchSize; ++i){
+                    int seq = b * kBatchSize + i;
+                    loop.queueInLoop([&, t, seq](){
+                        ordered = ordered && next[t] == seq;
+                        next[t] = seq + 1;
+                        if(++executed == kThreads * kBatches * kBatchSize){
+                            loop.quit();
+                        }
+                    });
+                }
+                ::usleep(100);
+            }
+        });
+    }
+    //唤醒丢了loop会一直睡下去，这里兜底退出，下面的检查就会失败
+    loop.runAfter(20.0, [&loop](){ loop.quit(); });
+    loop.loop();
+    for(std::thread& thread : threads){
+        thread.join();
+    }
+    CHECK(executed == kThreads * kBatches * kBatchSize);
+    CHECK(ordered);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    testQueue();
+    testDestroyReleasesItems();
+    testQueueInLoop();
+    printf("MpscQueue_test OK\n");
+    return 0;
+}
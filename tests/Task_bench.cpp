@@ -0,0 +1,117 @@
+//投递任务的开销：不同大小的闭包，装进Task和装进std::function各要几次分配、多少纳秒；
+//以及跨线程queueInLoop时投递方每次的分配数和耗时（Task直接装闭包 vs 先包成std::function再投递）
+//用法：Task_bench [每项次数=1000000]
+#include "Task.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Logger.h"
+#include "BenchUtil.h"
+
+#include <future>
+#include <functional>
+#include <new>
+#include <stdlib.h>
+
+namespace{
+//只统计本线程的分配，loop线程同时在分配也不影响
+thread_local size_t g_allocations = 0;
+}
+
+void* operator new(size_t size){
+    ++g_allocations;
+    void* p = ::malloc(size == 0 ? 1 : size);
+    if(p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept{
+    ::free(p);
+}
+
+namespace{
+
+//共Size字节的闭包，只在执行它的线程里累加hits
+template <size_t Size>
+struct Closure{
+    void operator()(){
+        *hits += 1;
+    }
+    long* hits;
+    char pad[Size - sizeof(long*)];
+};
+
+struct Cost{
+    double allocations;
+    double ns;
+};
+
+//构造、移动一次（相当于进出队列）、执行
+template <typename Wrapper, typename Fn>
+Cost localCost(long iterations){
+    long hits = 0;
+    Fn fn;
+    fn.hits = &hits;
+    size_t allocBefore = g_allocations;
+    int64_t begin = benchutil::nowNs();
+    for(long i = 0; i < iterations; ++i){
+        Wrapper wrapped(fn);
+        Wrapper moved(std::move(wrapped));
+        moved();
+    }
+    Cost cost = {static_cast<double>(g_allocations - allocBefore) / iterations,
+        static_cast<double>(benchutil::nowNs() - begin) / iterations};
+    return cost;
+}
+
+//投递方的分配和耗时，loop线程执行完全部任务后返回
+template <typename Fn>
+Cost postCost(EventLoop* loop, long iterations, bool viaFunction){
+    long hits = 0;
+    Fn fn;
+    fn.hits = &hits;
+    size_t allocBefore = g_allocations;
+    int64_t begin = benchutil::nowNs();
+    for(long i = 0; i < iterations; ++i){
+        if(viaFunction){
+            loop->queueInLoop(std::function<void()>(fn));
+        }else{
+            loop->queueInLoop(fn);
+        }
+    }
+    Cost cost = {static_cast<double>(g_allocations - allocBefore) / iterations,
+        static_cast<double>(benchutil::nowNs() - begin) / iterations};
+    std::promise<void> drained;
+    loop->queueInLoop([&drained](){ drained.set_value(); });
+    drained.get_future().wait();
+    return cost;
+}
+
+template <size_t Size>
+void runSize(EventLoop* loop, long iterations){
+    typedef Closure<Size> Fn;
+    Cost task = localCost<Task, Fn>(iterations);
+    Cost function = localCost<std::function<void()>, Fn>(iterations);
+    printf("closure %3zu bytes  local:  Task %.2f allocs %6.1f ns   std::function %.2f allocs %6.1f ns\n",
+        Size, task.allocations, task.ns, function.allocations, function.ns);
+    Cost postTask = postCost<Fn>(loop, iterations, false);
+    Cost postFunction = postCost<Fn>(loop, iterations, true);
+    printf("                    post:   Task %.2f allocs %6.1f ns   std::function %.2f allocs %6.1f ns\n",
+        postTask.allocations, postTask.ns, postFunction.allocations, postFunction.ns);
+}
+
+}
+
+int main(int argc, char* argv[]){
+    Logger::setLogLevel(ERROR);
+    long iterations = benchutil::argOr(argc, argv, 1, 1000000);
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+
+    runSize<16>(loop, iterations);
+    runSize<40>(loop, iterations);
+    runSize<Task::kInlineSize>(loop, iterations);
+    runSize<128>(loop, iterations);
+    return 0;
+}
@@ -0,0 +1,172 @@
+//Task：不超过64字节且移动不抛异常的可调用对象内联存放、构造和移动都不分配内存；更大的或移动可能抛异常的放到堆上只分配一次；
+//只能移动的可调用对象也能装；每个被装进去的对象恰好析构一次。
+//跨线程queueInLoop一个内联大小的闭包，投递方只有MPSC队列节点这一次分配
+#include "Task.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <memory>
+#include <vector>
+#include <new>
+#include <stdlib.h>
+#include <stdio.h>
+
+namespace{
+//只统计本线程的分配，loop线程同时在分配也不影响
+thread_local size_t g_allocations = 0;
+}
+
+void* operator new(size_t size){
+    ++g_allocations;
+    void* p = ::malloc(size == 0 ? 1 : size);
+    if(p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept{
+    ::free(p);
+}
+
+namespace{
+
+int g_alive = 0;
+
+//记录存活的实例数，检查不多析构也不漏析构
+struct Counted{
+    Counted(){ ++g_alive; }
+    Counted(const Counted&){ ++g_alive; }
+    Counted(Counted&&) noexcept { ++g_alive; }
+    ~Counted(){ --g_alive; }
+};
+
+struct Small{
+    void operator()(){ *hits += 1; }
+    std::shared_ptr<int> owner;
+    int* hits;
+    void* a;
+    void* b;
+    Counted counted;
+};
+
+struct Large{
+    void operator()(){ *hits += 10; }
+    int* hits;
+    char payload[100];
+    Counted counted;
+};
+
+//移动构造可能抛异常，不能内联
+struct ThrowingMove{
+    ThrowingMove(int* h) : hits(h){}
+    ThrowingMove(ThrowingMove&& rhs) : hits(rhs.hits){}
+    void operator()(){ *hits += 100; }
+    int* hits;
+    Counted counted;
+};
+
+struct MoveOnly{
+    void operator()(){ *hits += *value; }
+    int* hits;
+    std::unique_ptr<int> value;
+};
+
+void testInline(){
+    int hits = 0;
+    std::shared_ptr<int> owner = std::make_shared<int>(0);
+    Small small;
+    small.owner = owner;
+    small.hits = &hits;
+
+    std::vector<Task> tasks;
+    tasks.reserve(4);
+    size_t before = g_allocations;
+    Task task(std::move(small));
+    Task moved(std::move(task));
+    tasks.push_back(std::move(moved));
+    CHECK(g_allocations == before);
+    CHECK(!task && !moved);
+    tasks[0]();
+    CHECK(hits == 1);
+    tasks.clear();
+    CHECK(owner.use_count() == 1);
+}
+
+void testHeap(){
+    int hits = 0;
+    Large large;
+    large.hits = &hits;
+    size_t before = g_allocations;
+    Task task(large);
+    CHECK(g_allocations == before + 1);
+    Task moved(std::move(task));
+    CHECK(g_allocations == before + 1);
+    moved();
+    CHECK(hits == 10);
+
+    before = g_allocations;
+    Task throwing{ThrowingMove(&hits)};
+    CHECK(g_allocations == before + 1);
+    throwing();
+    CHECK(hits == 110);
+}
+
+void testMoveOnlyAndReset(){
+    int hits = 0;
+    MoveOnly fn;
+    fn.hits = &hits;
+    fn.value.reset(new int(5));
+    Task task(std::move(fn));
+    task();
+    CHECK(hits == 5);
+
+    //赋值和置空都要析构原来的对象
+    Task other([&hits](){ hits += 1000; });
+    task = std::move(other);
+    task();
+    CHECK(hits == 1005);
+    task = nullptr;
+    CHECK(!task);
+}
+
+void testQueueInLoop(){
+    EventLoop loop;
+    std::shared_ptr<int> owner = std::make_shared<int>(0);
+    int hits = 0;
+    size_t allocations = 0;
+    std::thread poster([&](){
+        size_t before = g_allocations;
+        for(int i = 0; i < 100; ++i){
+            loop.queueInLoop([owner, &hits, &loop](){
+                if(++hits == 100){
+                    loop.quit();
+                }
+            });
+        }
+        allocations = g_allocations - before;
+    });
+    loop.loop();
+    poster.join();
+    CHECK(hits == 100);
+    CHECK(allocations == 100);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    //Small在64位下：shared_ptr 16 + 三个指针 24 + Counted，内联
+    static_assert(sizeof(Small) <= Task::kInlineSize, "Small must fit inline");
+    testInline();
+    CHECK(g_alive == 0);
+    testHeap();
+    CHECK(g_alive == 0);
+    testMoveOnlyAndReset();
+    CHECK(g_alive == 0);
+    testQueueInLoop();
+    printf("Task_test OK\n");
+    return 0;
+}
@@ -0,0 +1,130 @@
+//读背压：对端只写不读时，回显服务的待发送数据超过高水位就停止读这个连接，数据堵在内核缓冲里、对端的写被TCP流控挡住；
+//对端开始读之后待发送数据降到低水位以下，恢复读并回调lowWaterMark，之前写进去的数据一个字节不少地回显回来。水平/边沿触发各跑一遍
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+
+namespace{
+
+const size_t kHighWaterMark = 64 * 1024;
+const size_t kLowWaterMark = 16 * 1024;
+//不停读的话服务端能把这么多数据全部堆进outputBuffer
+const size_t kMaxSend = 16 * 1024 * 1024;
+const size_t kChunk = 16 * 1024;
+
+char patternAt(size_t i){
+    return static_cast<char>(i * 7 % 251);
+}
+
+//客户端的缓冲固定得很小，关掉自动调整，服务端的发送缓冲写满后很快就会堵住
+int connectSmallBuffers(uint16_t port){
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(fd >= 0);
+    int size = 64 * 1024;
+    CHECK(::setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof size) == 0);
+    CHECK(::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof size) == 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0);
+    return fd;
+}
+
+//非阻塞地一直写，直到连续200毫秒写不进去为止，返回写进去的字节数
+size_t writeUntilStalled(int fd){
+    CHECK(::fcntl(fd, F_SETFL, O_NONBLOCK) == 0);
+    char chunk[kChunk];
+    size_t sent = 0;
+    while(sent < kMaxSend){
+        for(size_t i = 0; i < kChunk; ++i){
+            chunk[i] = patternAt(sent + i);
+        }
+        ssize_t n = ::write(fd, chunk, kChunk);
+        if(n > 0){
+            sent += n;
+            continue;
+        }
+        CHECK(errno == EAGAIN);
+        pollfd pfd = {fd, POLLOUT, 0};
+        if(::poll(&pfd, 1, 200) == 0){
+            break;
+        }
+    }
+    CHECK(::fcntl(fd, F_SETFL, 0) == 0);
+    return sent;
+}
+
+void testBackpressure(bool edgeTriggered){
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "BackpressureTest");
+    server.setEdgeTriggered(edgeTriggered);
+    server.setWaterMarks(kHighWaterMark, kLowWaterMark);
+    server.setReadBackpressure(true);
+
+    std::atomic<size_t> received(0);
+    std::atomic<int> lowWaterMarks(0);
+    size_t maxPending = 0;
+    server.setConnectionCallback([](const TcpConnectionPtr&){});
+    server.setMessageCallback([&](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+        received += buf->readableBytes();
+        conn->send(buf);
+        maxPending = std::max(maxPending, conn->outputBuffer()->readableBytes());
+    });
+    server.setLowWaterMarkCallback([&lowWaterMarks](const TcpConnectionPtr&){
+        ++lowWaterMarks;
+    });
+    server.start();
+
+    size_t sent = 0;
+    bool stalledReads = false;
+    std::thread client([&](){
+        int fd = connectSmallBuffers(port);
+        sent = writeUntilStalled(fd);
+
+        //堵住之后服务端不应该再读
+        size_t before = received;
+        ::usleep(100 * 1000);
+        stalledReads = received == before;
+
+        std::string echo(sent, '\0');
+        CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+        for(size_t i = 0; i < sent; ++i){
+            CHECK(echo[i] == patternAt(i));
+        }
+        ::close(fd);
+        loop.queueInLoop([&loop](){ loop.quit(); });
+    });
+    loop.loop();
+    client.join();
+
+    CHECK(sent < kMaxSend);
+    CHECK(stalledReads);
+    CHECK(received == sent);
+    CHECK(lowWaterMarks > 0);
+    //停读之前最多再多读一轮（水平触发一次read，边沿触发一个高水位）
+    CHECK(maxPending <= kHighWaterMark + 2 * EventLoop::kOverflowBufferSize);
+    printf("%s: stalled after %zu bytes, max pending %zu\n", edgeTriggered ? "ET" : "LT", sent, maxPending);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    testBackpressure(false);
+    testBackpressure(true);
+    printf("TcpConnection_backpressure_test OK\n");
+    return 0;
+}
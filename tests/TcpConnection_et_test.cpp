@@ -0,0 +1,102 @@
+//边沿触发的连接：大数据量回显要读/写到EAGAIN才不丢数据；stopRead/startRead不能产生epoll_ctl，
+//fd一直按EPOLLIN|EPOLLOUT|EPOLLET注册着，暂停期间到达的数据在startRead之后照常收到
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <future>
+#include <string>
+#include <errno.h>
+
+namespace{
+
+const size_t kPayload = 4 * 1024 * 1024;
+
+std::string pattern(size_t len){
+    std::string s(len, '\0');
+    for(size_t i = 0; i < len; ++i){
+        s[i] = static_cast<char>(i * 131 % 251);
+    }
+    return s;
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "EtTest");
+    server.setEdgeTriggered(true);
+
+    std::promise<TcpConnectionPtr> connected;
+    server.setConnectionCallback([&connected](const TcpConnectionPtr& conn){
+        if(conn->connected()){
+            connected.set_value(conn);
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+        conn->send(buf);
+    });
+    server.start();
+
+    uint64_t ctlBefore = 0;
+    uint64_t ctlPaused = 0;
+    uint64_t ctlAfter = 0;
+    bool echoedWhilePaused = true;
+    int fd = -1;
+
+    std::thread client([&](){
+        fd = testutil::connectTo(port);
+        CHECK(fd >= 0);
+        TcpConnectionPtr conn = connected.get_future().get();
+
+        //一边写一边读，两边的内核缓冲都会被写满好几次
+        std::string payload = pattern(kPayload);
+        std::thread writer([fd, &payload](){ testutil::sendAll(fd, payload); });
+        std::string echo(kPayload, '\0');
+        CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+        writer.join();
+        CHECK(echo == payload);
+
+        std::promise<void> paused;
+        loop.runInLoop([&](){
+            ctlBefore = loop.pollerCtlCalls();
+            conn->stopRead();
+            paused.set_value();
+        });
+        paused.get_future().wait();
+
+        testutil::sendAll(fd, "ping");
+        ::usleep(100 * 1000);
+        char c;
+        echoedWhilePaused = ::recv(fd, &c, 1, MSG_DONTWAIT) >= 0 || errno != EAGAIN;
+
+        loop.runInLoop([&](){
+            ctlPaused = loop.pollerCtlCalls();
+            conn->startRead();
+        });
+        char ping[4];
+        CHECK(testutil::readFull(fd, ping, sizeof ping));
+        CHECK(std::string(ping, sizeof ping) == "ping");
+
+        loop.runInLoop([&](){
+            ctlAfter = loop.pollerCtlCalls();
+            loop.quit();
+        });
+    });
+    loop.loop();
+    client.join();
+    //loop退出后再关，关闭连接的epoll_ctl不算进上面的统计
+    ::close(fd);
+
+    CHECK(!echoedWhilePaused);
+    CHECK(ctlPaused == ctlBefore);
+    CHECK(ctlAfter == ctlBefore);
+    printf("TcpConnection_et_test: %zu bytes echoed, %llu epoll_ctl calls OK\n", kPayload, static_cast<unsigned long long>(ctlAfter));
+    return 0;
+}
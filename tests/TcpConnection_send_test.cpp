@@ -0,0 +1,151 @@
+//多个生产者loop用各自pool里的Buffer跨线程send给同一个连接，同时自己也在用pool：
+//连接线程peek链式Buffer时会向别人的pool要存储。帧格式[长度4][生产者4][序号4][payload]，客户端逐帧校验。
+//同时统计send()本身的内存分配：连续Buffer只有MPSC队列节点一次，链式Buffer还要在堆上新建一个Buffer
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "Buffer.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <vector>
+#include <memory>
+#include <string>
+#include <new>
+#include <stdlib.h>
+#include <arpa/inet.h>
+
+namespace{
+thread_local size_t t_allocations = 0;
+}
+
+void* operator new(size_t size){
+    ++t_allocations;
+    void* p = ::malloc(size == 0 ? 1 : size);
+    if(p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept{
+    ::free(p);
+}
+
+namespace{
+
+const int kProducers = 4;
+const int kMessages = 200;
+const size_t kHeader = 12;
+
+char payloadByte(uint32_t producer, uint32_t seq, size_t i){
+    return static_cast<char>((producer * 31 + seq * 7 + i) & 0xff);
+}
+
+size_t payloadSize(uint32_t seq){
+    //跨越多个slab，保证链式Buffer的peek()需要合并
+    return 1000 + (seq % 5) * 15000;
+}
+
+void appendUint32(Buffer* buf, uint32_t v){
+    uint32_t be = htonl(v);
+    buf->append(reinterpret_cast<const char*>(&be), sizeof be);
+}
+
+uint32_t readUint32(const char* p){
+    uint32_t be;
+    memcpy(&be, p, sizeof be);
+    return ntohl(be);
+}
+
+void produce(EventLoop* loop, const TcpConnectionPtr& conn, uint32_t producer){
+    for(uint32_t seq = 0; seq < kMessages; ++seq){
+        Buffer buf(loop->bufferPool());
+        buf.setChained(seq % 2 == 0);
+        size_t size = payloadSize(seq);
+        std::string payload(size, '\0');
+        for(size_t i = 0; i < size; ++i){
+            payload[i] = payloadByte(producer, seq, i);
+        }
+        appendUint32(&buf, static_cast<uint32_t>(kHeader + size));
+        appendUint32(&buf, producer);
+        appendUint32(&buf, seq);
+        buf.append(payload.data(), payload.size());
+        //链式：堆上的Buffer，加上它的deque构造时分配的map和第一块节点
+        size_t expected = buf.chained() ? 4 : 1;
+        size_t before = t_allocations;
+        conn->send(&buf);
+        CHECK(t_allocations - before == expected);
+
+        //生产者loop自己也在用这个pool：读空即归还，让空闲链表在生产者线程里不停变化
+        Buffer scratch(loop->bufferPool());
+        scratch.append(payload.data(), payload.size());
+        scratch.retrieveAll();
+    }
+}
+
+void client(uint16_t port, EventLoop* serverLoop){
+    int fd = testutil::connectTo(port);
+    CHECK(fd >= 0);
+
+    std::vector<uint32_t> nextSeq(kProducers, 0);
+    std::vector<char> frame;
+    for(int received = 0; received < kProducers * kMessages; ++received){
+        char header[kHeader];
+        CHECK(testutil::readFull(fd, header, kHeader));
+        uint32_t len = readUint32(header);
+        uint32_t producer = readUint32(header + 4);
+        uint32_t seq = readUint32(header + 8);
+        CHECK(producer < static_cast<uint32_t>(kProducers));
+        CHECK(seq == nextSeq[producer]);
+        CHECK(len == kHeader + payloadSize(seq));
+        frame.resize(len - kHeader);
+        CHECK(testutil::readFull(fd, frame.data(), frame.size()));
+        for(size_t i = 0; i < frame.size(); ++i){
+            CHECK(frame[i] == payloadByte(producer, seq, i));
+        }
+        ++nextSeq[producer];
+    }
+    ::close(fd);
+    serverLoop->quit();
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "SendTest");
+    server.setThreadNum(1);
+
+    std::vector<std::unique_ptr<EventLoopThread>> producers;
+    std::vector<EventLoop*> producerLoops;
+    for(int i = 0; i < kProducers; ++i){
+        producers.emplace_back(new EventLoopThread());
+        producerLoops.push_back(producers.back()->startLoop());
+    }
+
+    server.setConnectionCallback([&producerLoops](const TcpConnectionPtr& conn){
+        if(!conn->connected()){
+            return;
+        }
+        for(int i = 0; i < kProducers; ++i){
+            EventLoop* producerLoop = producerLoops[i];
+            producerLoop->runInLoop([producerLoop, conn, i]{
+                produce(producerLoop, conn, static_cast<uint32_t>(i));
+            });
+        }
+    });
+    server.start();
+
+    std::thread clientThread(client, port, &loop);
+    loop.loop();
+    clientThread.join();
+
+    printf("TcpConnection_send_test: %d frames from %d producers OK\n", kProducers * kMessages, kProducers);
+    return 0;
+}
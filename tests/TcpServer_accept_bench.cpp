@@ -0,0 +1,107 @@
+//短连接压力下的accept：三种accept模式各跑一遍，客户端线程不停地 连接-发1字节-收回显-关闭，
+//统计每秒完成的连接数和从connect到收到回显的延迟分布
+//用法：TcpServer_accept_bench [subLoop数=4] [客户端线程数=8] [秒数=2] [acceptBatch=0表示用默认值]
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "BenchUtil.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+
+namespace{
+
+//SO_LINGER为0时close直接发RST，客户端不留TIME_WAIT，跑久了也不会耗尽本地端口
+int connectNoLinger(uint16_t port){
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0){
+        return -1;
+    }
+    linger lin = {1, 0};
+    ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof lin);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0){
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void run(TcpServer::AcceptMode mode, const char* modeName, int threads, int clients, double seconds, int batch){
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "AcceptBench");
+    server.setAcceptMode(mode);
+    server.setThreadNum(threads);
+    if(batch > 0){
+        server.setAcceptBatch(batch);
+    }
+    server.setConnectionCallback([](const TcpConnectionPtr&){});
+    server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+        conn->send(buf);
+    });
+    server.start();
+
+    std::atomic<bool> stop(false);
+    std::atomic<long> failures(0);
+    std::mutex mutex;
+    std::vector<int64_t> latencies;
+    std::vector<std::thread> workers;
+    for(int i = 0; i < clients; ++i){
+        workers.emplace_back([&](){
+            std::vector<int64_t> mine;
+            while(!stop){
+                int64_t begin = benchutil::nowNs();
+                int fd = connectNoLinger(port);
+                char c = 'x';
+                if(fd < 0 || ::write(fd, &c, 1) != 1 || ::read(fd, &c, 1) != 1){
+                    ++failures;
+                }else{
+                    mine.push_back(benchutil::nowNs() - begin);
+                }
+                if(fd >= 0){
+                    ::close(fd);
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.insert(latencies.end(), mine.begin(), mine.end());
+        });
+    }
+    //客户端全部退出之前loop一直要服务，否则单Acceptor模式下正在连接的客户端会卡在read上
+    std::thread joiner([&](){
+        ::usleep(static_cast<useconds_t>(seconds * 1000 * 1000));
+        stop = true;
+        for(std::thread& worker : workers){
+            worker.join();
+        }
+        loop.queueInLoop([&loop](){ loop.quit(); });
+    });
+    loop.loop();
+    joiner.join();
+
+    printf("%-20s %.0f connections/s, %ld failed\n", modeName, latencies.size() / seconds, failures.load());
+    benchutil::printLatency("  connect-to-echo", &latencies);
+}
+
+}
+
+int main(int argc, char* argv[]){
+    Logger::setLogLevel(FATAL);
+    int threads = static_cast<int>(benchutil::argOr(argc, argv, 1, 4));
+    int clients = static_cast<int>(benchutil::argOr(argc, argv, 2, 8));
+    double seconds = static_cast<double>(benchutil::argOr(argc, argv, 3, 2));
+    int batch = static_cast<int>(benchutil::argOr(argc, argv, 4, 0));
+
+    run(TcpServer::kSingleAcceptor, "single acceptor", threads, clients, seconds, batch);
+    run(TcpServer::kReusePortPerLoop, "reuseport per loop", threads, clients, seconds, batch);
+    run(TcpServer::kExclusivePerLoop, "exclusive per loop", threads, clients, seconds, batch);
+    return 0;
+}
@@ -0,0 +1,111 @@
+//每个loop自己accept的两种模式：连接都在subLoop上服务、能正常收发；
+//以及有客户端不停连接时析构TcpServer，不能有连接落到已经释放的server上
+#include "TcpServer.h"
+#include "TcpConnection.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace{
+
+const int kThreads = 3;
+const int kConnections = 30;
+
+void echoClients(uint16_t port, EventLoop* baseLoop){
+    for(int i = 0; i < kConnections; ++i){
+        int fd = testutil::connectTo(port);
+        CHECK(fd >= 0);
+        std::string message = "hello " + std::to_string(i);
+        testutil::sendAll(fd, message);
+        std::string echo(message.size(), '\0');
+        CHECK(testutil::readFull(fd, &echo[0], echo.size()));
+        CHECK(echo == message);
+        ::close(fd);
+    }
+    baseLoop->quit();
+}
+
+void testServing(TcpServer::AcceptMode mode){
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    TcpServer server(&loop, InetAddress(port), "AcceptTest");
+    server.setAcceptMode(mode);
+    server.setThreadNum(kThreads);
+
+    std::mutex mutex;
+    std::set<EventLoop*> servingLoops;
+    bool servedOnBase = false;
+    server.setConnectionCallback([&](const TcpConnectionPtr& conn){
+        if(conn->connected()){
+            std::lock_guard<std::mutex> lock(mutex);
+            servingLoops.insert(conn->getLoop());
+            servedOnBase = servedOnBase || conn->getLoop() == &loop;
+        }
+    });
+    server.setMessageCallback([](const TcpConnectionPtr& conn, Buffer* buf, TimeStamp){
+        conn->send(buf);
+    });
+    server.start();
+
+    std::thread client(echoClients, port, &loop);
+    loop.loop();
+    client.join();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK(!servedOnBase);
+    CHECK(!servingLoops.empty());
+    printf("mode %d: %d connections served on %zu loops\n", static_cast<int>(mode), kConnections, servingLoops.size());
+}
+
+//析构时客户端还在不停地连，析构返回后任何loop都不能再调用这个server
+void testDestroyWhileConnecting(TcpServer::AcceptMode mode){
+    EventLoop loop;
+    uint16_t port = testutil::pickPort();
+    std::atomic<bool> stop(false);
+    std::atomic<int> accepted(0);
+
+    TcpServer* server = new TcpServer(&loop, InetAddress(port), "DestroyTest");
+    server->setAcceptMode(mode);
+    server->setThreadNum(kThreads);
+    server->setConnectionCallback([&accepted](const TcpConnectionPtr& conn){
+        if(conn->connected()){
+            ++accepted;
+        }
+    });
+    server->start();
+
+    std::thread client([port, &stop](){
+        while(!stop){
+            int fd = testutil::connectTo(port);
+            if(fd >= 0){
+                ::close(fd);
+            }
+        }
+    });
+    loop.runAfter(0.2, [&loop](){ loop.quit(); });
+    loop.loop();
+    delete server;
+    //server的线程池随server一起退出，这里再给客户端一点时间撞上残留的监听socket
+    ::usleep(50 * 1000);
+    stop = true;
+    client.join();
+    CHECK(accepted > 0);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    testServing(TcpServer::kReusePortPerLoop);
+    testServing(TcpServer::kExclusivePerLoop);
+    testDestroyWhileConnecting(TcpServer::kReusePortPerLoop);
+    testDestroyWhileConnecting(TcpServer::kExclusivePerLoop);
+    printf("TcpServer_acceptor_test OK\n");
+    return 0;
+}
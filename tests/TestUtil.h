@@ -0,0 +1,87 @@
+#pragma once
+
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+//tests/下各测试程序共用：失败即退出的断言，以及客户端一侧的阻塞socket小工具
+
+#define CHECK(cond) do{ if(!(cond)){ fprintf(stderr, "%s:%d CHECK failed: %s\n", __FILE__, __LINE__, #cond); exit(1); } }while(0)
+
+namespace testutil{
+
+//让内核挑一个空闲端口再放掉，给测试里的server用
+inline uint16_t pickPort(){
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(fd >= 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) == 0);
+    socklen_t len = sizeof addr;
+    CHECK(::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0);
+    ::close(fd);
+    return ntohs(addr.sin_port);
+}
+
+//连不上返回-1
+inline int connectTo(uint16_t port){
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(fd >= 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof addr);
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0){
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+inline void sendAll(int fd, const char* data, size_t len){
+    while(len > 0){
+        ssize_t n = ::write(fd, data, len);
+        CHECK(n > 0);
+        data += n;
+        len -= n;
+    }
+}
+
+inline void sendAll(int fd, const std::string& data){
+    sendAll(fd, data.data(), data.size());
+}
+
+//读满len字节，对端提前关闭返回false
+inline bool readFull(int fd, char* p, size_t len){
+    while(len > 0){
+        ssize_t n = ::read(fd, p, len);
+        if(n <= 0){
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+//读到对端关闭写端为止
+inline std::string readUntilEof(int fd){
+    std::string result;
+    char buf[4096];
+    ssize_t n;
+    while((n = ::read(fd, buf, sizeof buf)) > 0){
+        result.append(buf, n);
+    }
+    return result;
+}
+
+}
@@ -0,0 +1,71 @@
+//定时器按到期时间先后触发；重复定时器能在自己的回调里cancel；别的线程cancel还没到期的定时器；
+//对已经触发过的一次性定时器cancel什么也不做
+#include "EventLoop.h"
+#include "EventLoopThread.h"
+#include "TimeStamp.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <vector>
+#include <atomic>
+#include <future>
+#include <stdio.h>
+
+namespace{
+
+void testOrder(){
+    EventLoop loop;
+    std::vector<int> fired;
+    loop.runAfter(0.03, [&fired](){ fired.push_back(3); });
+    loop.runAfter(0.01, [&fired](){ fired.push_back(1); });
+    loop.runAfter(0.02, [&fired](){ fired.push_back(2); });
+    //已经过去的时间点，下一轮就触发
+    loop.runAt(TimeStamp(TimeStamp::now().microSecondsSinceEpoch() - 1000), [&fired](){ fired.push_back(0); });
+    loop.runAfter(0.05, [&loop](){ loop.quit(); });
+    loop.loop();
+    CHECK((fired == std::vector<int>{0, 1, 2, 3}));
+}
+
+void testCancelEveryInCallback(){
+    EventLoop loop;
+    int count = 0;
+    TimerId every;
+    every = loop.runEvery(0.005, [&](){
+        if(++count == 3){
+            loop.cancel(every);
+        }
+    });
+    loop.runAfter(0.1, [&loop](){ loop.quit(); });
+    loop.loop();
+    CHECK(count == 3);
+}
+
+void testCancelFromOtherThread(){
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    std::atomic<int> fired(0);
+    TimerId once = loop->runAfter(0.05, [&fired](){ ++fired; });
+    TimerId every = loop->runEvery(0.01, [&fired](){ fired += 100; });
+    loop->cancel(once);
+    loop->cancel(every);
+
+    //已经触发过的一次性定时器，cancel不能出问题
+    std::promise<void> done;
+    TimerId fast = loop->runAfter(0.001, [&done](){ done.set_value(); });
+    done.get_future().wait();
+    loop->cancel(fast);
+
+    ::usleep(100 * 1000);
+    CHECK(fired == 0);
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+    testOrder();
+    testCancelEveryInCallback();
+    testCancelFromOtherThread();
+    printf("TimerQueue_test OK\n");
+    return 0;
+}
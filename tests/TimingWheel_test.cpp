@@ -0,0 +1,71 @@
+//时间轮：到期时间不早于timeout；被反复schedule刷新的entry不到期；超过一圈的timeout要多转几圈才到期；cancel之后不再回调
+#include "TimingWheel.h"
+#include "EventLoop.h"
+#include "Logger.h"
+#include "TestUtil.h"
+
+#include <chrono>
+#include <stdio.h>
+
+namespace{
+
+using Clock = std::chrono::steady_clock;
+
+const double kTick = 0.01;
+const int kBuckets = 8;
+
+double elapsed(Clock::time_point start){
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}
+
+int main(){
+    Logger::setLogLevel(ERROR);
+
+    EventLoop loop;
+    TimingWheel wheel(&loop, kTick, kBuckets);
+    Clock::time_point start = Clock::now();
+
+    double onceAt = -1;
+    TimingWheel::Entry once;
+    once.setExpireCallback([&](){ onceAt = elapsed(start); });
+    wheel.schedule(&once, 0.03);
+
+    //一圈是kTick * kBuckets = 0.08秒
+    double longAt = -1;
+    TimingWheel::Entry longer;
+    longer.setExpireCallback([&](){ longAt = elapsed(start); });
+    wheel.schedule(&longer, 0.2);
+
+    bool canceledFired = false;
+    TimingWheel::Entry canceled;
+    canceled.setExpireCallback([&](){ canceledFired = true; });
+    wheel.schedule(&canceled, 0.02);
+    CHECK(wheel.size() == 3);
+    wheel.cancel(&canceled);
+    CHECK(!canceled.scheduled());
+    CHECK(wheel.size() == 2);
+
+    //前0.15秒每5毫秒刷新一次，之后不再刷新
+    double refreshedAt = -1;
+    TimingWheel::Entry refreshed;
+    refreshed.setExpireCallback([&](){ refreshedAt = elapsed(start); });
+    wheel.schedule(&refreshed, 0.03);
+    loop.runEvery(0.005, [&](){
+        if(elapsed(start) < 0.15 && refreshed.scheduled()){
+            wheel.schedule(&refreshed, 0.03);
+        }
+    });
+
+    loop.runAfter(0.4, [&loop](){ loop.quit(); });
+    loop.loop();
+
+    CHECK(onceAt >= 0.03 && onceAt < 0.2);
+    CHECK(longAt >= 0.2 && longAt < 0.35);
+    CHECK(refreshedAt >= 0.15 + 0.03 && refreshedAt < 0.35);
+    CHECK(!canceledFired);
+    CHECK(wheel.size() == 0);
+    printf("TimingWheel_test: once %.3f s, longer %.3f s, refreshed %.3f s OK\n", onceAt, longAt, refreshedAt);
+    return 0;
+}